@@ -0,0 +1,151 @@
+// Transform + MeshInstance join, the pass render_snapshots_capture makes over every mesh instance.
+// Compares looking each transform up through the sparse index, gathering through cached dense
+// indices in arbitrary order (what capture did before store_follow), the same gather once
+// World::transforms follows the mesh order, and a chunk walk of the pair in archetype storage.
+//
+// Standalone console program, from the repository root:
+//   cl /O2 /std:c++14 /EHs-c- bench\ecs_join.cpp src\core\memory.cpp
+//   ecs_join.exe [entity count]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/ecs/world.hpp"
+#include "../src/ecs/sort.hpp"
+#include "../src/ecs/archetype.hpp"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+static f64 now() {
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+}
+
+static u32 rng_state = 0x9E3779B9u;
+
+static u32 rng_next() {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+constexpr u32 ASSET_COUNT = 50;
+constexpr u32 RUNS = 50;
+
+int main(int argc, char** argv) {
+	u32 count = argc > 1 ? (u32)atoi(argv[1]) : 1000000;
+
+	ecs::World world;
+	ecs::world_init(&world, count + 1);
+	ecs::Entity* entities = (ecs::Entity*)memory::malloc(count * sizeof(ecs::Entity));
+	ecs::pool_create_n(&world.pool, count, entities);
+
+	// Transforms in one shuffled order, mesh instances in another, then meshes sorted by asset as capture does
+	for (u32 i = count - 1; i > 0; i--) {
+		u32 j = rng_next() % (i + 1);
+		ecs::Entity e = entities[i]; entities[i] = entities[j]; entities[j] = e;
+	}
+	for (u32 i = 0; i < count; i++) {
+		ecs::Transform t = {};
+		t.rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+		t.scale = { 1.0f, 1.0f, 1.0f };
+		t.local_to_world = mat3x4_from_trs({ (f32)i, 0.0f, 0.0f }, t.rotation, t.scale);
+		ecs::store_add(&world.transforms, entities[i], t);
+	}
+	for (u32 i = 0; i < count; i++) {
+		ecs::store_add(&world.mesh_instances, entities[((u64)i * 7919) % count], ecs::MeshInstance{ rng_next() % ASSET_COUNT });
+	}
+	ecs::SortScratch scratch = {};
+	ecs::store_sort(&world.mesh_instances, [](const ecs::MeshInstance& mi) { return mi.asset_id; }, &scratch);
+
+	mat3x4* models = (mat3x4*)memory::malloc(count * sizeof(mat3x4));
+	u32* asset_ids = (u32*)memory::malloc(count * sizeof(u32));
+	u32* transform_index = (u32*)memory::malloc(count * sizeof(u32));
+	const ecs::Entity* mesh_entities = world.mesh_instances.entities.data;
+	const ecs::MeshInstance* meshes = world.mesh_instances.data.data;
+
+	f64 sparse = 1e9, gather = 1e9, follow = 1e9;
+	for (u32 run = 0; run < RUNS; run++) {
+		f64 start = now();
+		for (u32 i = 0; i < count; i++) {
+			models[i] = ecs::store_get(&world.transforms, mesh_entities[i])->local_to_world;
+			asset_ids[i] = meshes[i].asset_id;
+		}
+		f64 t = now() - start;
+		if (t < sparse) sparse = t;
+	}
+
+	for (u32 i = 0; i < count; i++) transform_index[i] = ecs::sparse_get(&world.transforms.sparse, ecs::entity_index(mesh_entities[i]));
+	for (u32 run = 0; run < RUNS; run++) {
+		f64 start = now();
+		const ecs::Transform* transforms = world.transforms.data.data;
+		for (u32 i = 0; i < count; i++) {
+			models[i] = transforms[transform_index[i]].local_to_world;
+			asset_ids[i] = meshes[i].asset_id;
+		}
+		f64 t = now() - start;
+		if (t < gather) gather = t;
+	}
+
+	f64 follow_start = now();
+	ecs::store_follow(&world.transforms, &world.mesh_instances, &scratch);
+	f64 follow_cost = now() - follow_start;
+	for (u32 i = 0; i < count; i++) transform_index[i] = ecs::sparse_get(&world.transforms.sparse, ecs::entity_index(mesh_entities[i]));
+	for (u32 run = 0; run < RUNS; run++) {
+		f64 start = now();
+		const ecs::Transform* transforms = world.transforms.data.data;
+		for (u32 i = 0; i < count; i++) {
+			models[i] = transforms[transform_index[i]].local_to_world;
+			asset_ids[i] = meshes[i].asset_id;
+		}
+		f64 t = now() - start;
+		if (t < follow) follow = t;
+	}
+
+	// The same rows kept together in chunks, in mesh order
+	ecs::ArchetypeStorage chunked;
+	ecs::archetype_storage_init(&chunked);
+	for (u32 i = 0; i < count; i++) {
+		ecs::archetype_add(&chunked, mesh_entities[i], *ecs::store_get(&world.transforms, mesh_entities[i]), meshes[i]);
+	}
+	f64 chunks = 1e9;
+	for (u32 run = 0; run < RUNS; run++) {
+		f64 start = now();
+		u32 next = 0;
+		ecs::archetype_each<ecs::Transform, ecs::MeshInstance>(&chunked,
+			[&](const ecs::Entity*, ecs::Transform* t, ecs::MeshInstance* mi, u32 n) {
+				for (u32 i = 0; i < n; i++) {
+					models[next + i] = t[i].local_to_world;
+					asset_ids[next + i] = mi[i].asset_id;
+				}
+				next += n;
+			});
+		f64 t = now() - start;
+		if (t < chunks) chunks = t;
+	}
+
+	// Keeps the copies observable
+	f32 checksum = 0.0f;
+	for (u32 i = 0; i < count; i += 997) checksum += models[i].row[0][3] + (f32)asset_ids[i];
+
+	printf("%u entities, best of %u runs (checksum %g)\n", count, RUNS, checksum);
+	printf("  sparse-set join (store_get)     %8.3f ms\n", sparse * 1000.0);
+	printf("  cached index gather, scattered  %8.3f ms\n", gather * 1000.0);
+	printf("  cached index gather, followed   %8.3f ms\n", follow * 1000.0);
+	printf("  store_follow itself (one-off)   %8.3f ms\n", follow_cost * 1000.0);
+	printf("  archetype chunks                %8.3f ms\n", chunks * 1000.0);
+
+	ecs::archetype_storage_destroy(&chunked);
+	memory::free(transform_index);
+	memory::free(asset_ids);
+	memory::free(models);
+	ecs::sort_scratch_destroy(&scratch);
+	memory::free(entities);
+	ecs::world_destroy(&world);
+	return 0;
+}
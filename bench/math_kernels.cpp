@@ -0,0 +1,217 @@
+// Checks every SSE kernel in core/math.hpp against its *_scalar reference on random input, then
+// times the per-entity ones both ways. Results must match exactly; a mismatch means a kernel no
+// longer does the reference's operations in the reference's order.
+//
+// Standalone console program, from the repository root (/fp:precise, the default, keeps the
+// compiler from contracting either side into FMAs):
+//   cl /O2 /std:c++14 /EHs-c- bench\math_kernels.cpp
+//   math_kernels.exe
+// Exits with 1 when any kernel disagrees with its reference.
+
+#include <stdio.h>
+
+#include "../src/core/math.hpp"
+#include "../src/ecs/transform_columns.hpp"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+static f64 now() {
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+}
+
+static u32 rng_state = 0x2545F491u;
+
+static f32 random_f32(f32 range) {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return ((f32)(rng_state >> 8) / (f32)(1u << 24) * 2.0f - 1.0f) * range;
+}
+
+static vec3 random_vec3(f32 range) {
+	return { random_f32(range), random_f32(range), random_f32(range) };
+}
+
+static mat4 random_mat4() {
+	mat4 m;
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 4; r++) m.col[c][r] = random_f32(4.0f);
+	}
+	return m;
+}
+
+static quat random_rotation() {
+	quat q = { random_f32(1.0f), random_f32(1.0f), random_f32(1.0f), random_f32(1.0f) };
+	f32 len = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	return { q.x / len, q.y / len, q.z / len, q.w / len };
+}
+
+static mat3x4 random_mat3x4() {
+	quat q = random_rotation();
+	vec3 scale = random_vec3(3.0f);
+	return mat3x4_from_trs(random_vec3(100.0f), q, scale);
+}
+
+static AABB random_aabb() {
+	vec3 a = random_vec3(10.0f);
+	vec3 b = random_vec3(10.0f);
+	return { { fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z) }, { fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z) } };
+}
+
+static bool same(const f32* a, const f32* b, u32 count) {
+	for (u32 i = 0; i < count; i++) {
+		if (a[i] != b[i]) return false;
+	}
+	return true;
+}
+
+static u32 failures = 0;
+
+static void expect(bool ok, const char* kernel, u32 iteration) {
+	if (ok) return;
+	if (failures < 10) printf("MISMATCH %s at iteration %u\n", kernel, iteration);
+	failures++;
+}
+
+constexpr u32 CHECKS = 1000000;
+constexpr u32 BENCH_COUNT = 1u << 16;
+constexpr u32 BENCH_RUNS = 200;
+
+static mat3x4 bench_models[BENCH_COUNT];
+static AABB   bench_boxes[BENCH_COUNT];
+static AABB   bench_out[BENCH_COUNT];
+static mat3x4 bench_products[BENCH_COUNT];
+static ecs::Transform bench_transforms[BENCH_COUNT];
+static TrsBlock bench_block;
+static u32 bench_dense[TRS_BLOCK];
+
+template<typename Fn>
+static f64 best_of(Fn fn) {
+	f64 best = 1e9;
+	for (u32 run = 0; run < BENCH_RUNS; run++) {
+		f64 start = now();
+		fn();
+		f64 t = now() - start;
+		if (t < best) best = t;
+	}
+	return best;
+}
+
+int main() {
+#if !MATH_SSE
+	printf("MATH_SSE is off for this build, every kernel is its scalar reference\n");
+#endif
+
+	for (u32 i = 0; i < CHECKS; i++) {
+		mat4 a = random_mat4();
+		mat4 b = random_mat4();
+		mat4 p = mat4_mul(a, b);
+		mat4 q = mat4_mul_scalar(a, b);
+		expect(same(&p.col[0][0], &q.col[0][0], 16), "mat4_mul", i);
+
+		vec3 v = random_vec3(50.0f);
+		vec3 tp = mat4_transform_point(a, v);
+		vec3 tq = mat4_transform_point_scalar(a, v);
+		expect(same(&tp.x, &tq.x, 3), "mat4_transform_point", i);
+		tp = mat4_transform_dir(a, v);
+		tq = mat4_transform_dir_scalar(a, v);
+		expect(same(&tp.x, &tq.x, 3), "mat4_transform_dir", i);
+
+		AABB box = random_aabb();
+		AABB bp = aabb_transform(box, a);
+		AABB bq = aabb_transform_scalar(box, a);
+		expect(same(&bp.min.x, &bq.min.x, 6), "aabb_transform (mat4)", i);
+
+		Frustum fp = frustum_from_vp(a);
+		Frustum fq = frustum_from_vp_scalar(a);
+		expect(same(&fp.planes[0].x, &fq.planes[0].x, 24), "frustum_from_vp", i);
+
+		mat3x4 m = random_mat3x4();
+		mat3x4 n = random_mat3x4();
+		mat3x4 mp = mat3x4_mul(m, n);
+		mat3x4 mq = mat3x4_mul_scalar(m, n);
+		expect(same(&mp.row[0][0], &mq.row[0][0], 12), "mat3x4_mul", i);
+
+		bp = aabb_transform(box, m);
+		bq = aabb_transform_scalar(box, m);
+		expect(same(&bp.min.x, &bq.min.x, 6), "aabb_transform (mat3x4)", i);
+		vec3 cp, ep, cq, eq;
+		aabb_transform_center_extent(box, m, &cp, &ep);
+		aabb_transform_center_extent_scalar(box, m, &cq, &eq);
+		expect(same(&cp.x, &cq.x, 3) && same(&ep.x, &eq.x, 3), "aabb_transform_center_extent (mat3x4)", i);
+	}
+	// transform_compose covers the column gather and scatter as well as the 8-wide kernel
+	for (u32 k = 0; k < TRS_BLOCK; k++) bench_dense[k] = k;
+	for (u32 i = 0; i < CHECKS / TRS_BLOCK; i++) {
+		ecs::Transform transforms[TRS_BLOCK];
+		u32 count = 1 + i % TRS_BLOCK;
+		for (u32 k = 0; k < count; k++) {
+			transforms[k].position = random_vec3(100.0f);
+			transforms[k].rotation = random_rotation();
+			transforms[k].scale = random_vec3(3.0f);
+		}
+		ecs::transform_compose(&bench_block, transforms, bench_dense, count);
+		for (u32 k = 0; k < count; k++) {
+			const ecs::Transform& t = transforms[k];
+			mat3x4 q = mat3x4_from_trs(t.position, t.rotation, t.scale);
+			expect(same(&t.local_to_world.row[0][0], &q.row[0][0], 12), "transform_compose", i);
+		}
+	}
+	printf("%u random inputs per kernel: %u mismatches\n", CHECKS, failures);
+
+	for (u32 i = 0; i < BENCH_COUNT; i++) {
+		bench_models[i] = random_mat3x4();
+		bench_boxes[i] = random_aabb();
+	}
+	f64 simd = best_of([] {
+		for (u32 i = 0; i < BENCH_COUNT; i++) bench_out[i] = aabb_transform(bench_boxes[i], bench_models[i]);
+	});
+	f64 scalar = best_of([] {
+		for (u32 i = 0; i < BENCH_COUNT; i++) bench_out[i] = aabb_transform_scalar(bench_boxes[i], bench_models[i]);
+	});
+	// Keeps the results observable
+	f32 checksum = 0.0f;
+	for (u32 i = 0; i < BENCH_COUNT; i += 97) checksum += bench_out[i].max.x - bench_out[i].min.y;
+	printf("aabb_transform (mat3x4), %u boxes: %.2f ns/box, scalar %.2f ns/box (checksum %g)\n",
+		BENCH_COUNT, simd * 1e9 / BENCH_COUNT, scalar * 1e9 / BENCH_COUNT, checksum);
+
+	simd = best_of([] {
+		for (u32 i = 0; i + 1 < BENCH_COUNT; i++) bench_products[i] = mat3x4_mul(bench_models[i + 1], bench_models[i]);
+	});
+	scalar = best_of([] {
+		for (u32 i = 0; i + 1 < BENCH_COUNT; i++) bench_products[i] = mat3x4_mul_scalar(bench_models[i + 1], bench_models[i]);
+	});
+	checksum = 0.0f;
+	for (u32 i = 0; i < BENCH_COUNT; i += 97) checksum += bench_products[i].row[0][3];
+	printf("mat3x4_mul, %u products: %.2f ns/product, scalar %.2f ns/product (checksum %g)\n",
+		BENCH_COUNT - 1, simd * 1e9 / (BENCH_COUNT - 1), scalar * 1e9 / (BENCH_COUNT - 1), checksum);
+
+	// The local transform pass over every record, a word at a time through columns and record by record
+	for (u32 i = 0; i < BENCH_COUNT; i++) {
+		bench_transforms[i].position = random_vec3(100.0f);
+		bench_transforms[i].rotation = random_rotation();
+		bench_transforms[i].scale = random_vec3(3.0f);
+	}
+	simd = best_of([] {
+		for (u32 base = 0; base < BENCH_COUNT; base += TRS_BLOCK) {
+			ecs::transform_compose(&bench_block, bench_transforms + base, bench_dense, TRS_BLOCK);
+		}
+	});
+	scalar = best_of([] {
+		for (u32 i = 0; i < BENCH_COUNT; i++) {
+			ecs::Transform& t = bench_transforms[i];
+			t.local_to_world = mat3x4_from_trs(t.position, t.rotation, t.scale);
+		}
+	});
+	checksum = 0.0f;
+	for (u32 i = 0; i < BENCH_COUNT; i += 97) checksum += bench_transforms[i].local_to_world.row[1][2];
+	printf("Transform TRS pass, %u records: %.2f ns/record in columns, per record %.2f ns (checksum %g)\n",
+		BENCH_COUNT, simd * 1e9 / BENCH_COUNT, scalar * 1e9 / BENCH_COUNT, checksum);
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#version 450 core
+#extension GL_ARB_bindless_texture : require
+
+in vec2 v_uv;
+flat in uint v_draw;
+
+// Albedo handle per indirect draw, in command order
+layout(std430, binding = 1) buffer DrawTextures {
+	sampler2D albedo[];
+};
+
+out vec4 frag_color;
+
+void main() {
+	frag_color = texture(albedo[v_draw], v_uv);
+}
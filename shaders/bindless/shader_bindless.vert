@@ -0,0 +1,26 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec3 a_normal;
+layout(location = 2) in vec2 a_uv;
+layout(location = 3) in vec4 a_tangent;
+// base_instance + gl_InstanceID, or with GPU culling the snapshot entry the cull pass put in that slot
+layout(location = 4) in uint a_instance;
+
+// Affine rows of each model matrix (C++ mat3x4): vec4(p, 1) * models[i] is the world position
+layout(std430, binding = 0) buffer TransformBuffer {
+	mat3x4 models[];
+};
+
+uniform mat4 u_vp;
+
+out vec2 v_uv;
+flat out uint v_draw;
+
+void main() {
+	vec3 world_pos = vec4(a_position, 1.0) * models[a_instance];
+	gl_Position = u_vp * vec4(world_pos, 1.0);
+	v_uv = a_uv;
+	v_draw = uint(gl_DrawIDARB);
+}
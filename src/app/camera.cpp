@@ -49,4 +49,19 @@ mat4 camera_get_view(const Camera* cam) {
     vec3 world_up = { 0.0f, 1.0f, 0.0f };
 
     return mat4_look_at(cam->position, target, world_up);
-}
\ No newline at end of file
+}
+
+void camera_get_ray(const Camera* cam, f32 fov_y, f32 aspect, f32 ndc_x, f32 ndc_y, vec3* origin, vec3* dir) {
+    vec3 forward = {
+        cosf(cam->pitch) * sinf(cam->yaw),
+        sinf(cam->pitch),
+        cosf(cam->pitch) * cosf(cam->yaw)
+    };
+    vec3 world_up = { 0.0f, 1.0f, 0.0f };
+    vec3 right = normalize(cross(forward, world_up));
+    vec3 up = cross(right, forward);
+
+    f32 tan_half = tanf(fov_y * 0.5f);
+    *origin = cam->position;
+    *dir = normalize(forward + right * (ndc_x * tan_half * aspect) + up * (ndc_y * tan_half));
+}
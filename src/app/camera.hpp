@@ -12,4 +12,6 @@ struct Camera {
 
 void camera_init(Camera* cam, vec3 pos, f32 speed, f32 sensitivity);
 void camera_update(Camera* cam, f32 dt);
-mat4 camera_get_view(const Camera* cam);
\ No newline at end of file
+mat4 camera_get_view(const Camera* cam);
+// World-space ray through a point in normalized device coordinates ([-1, 1], y up).
+void camera_get_ray(const Camera* cam, f32 fov_y, f32 aspect, f32 ndc_x, f32 ndc_y, vec3* origin, vec3* dir);
\ No newline at end of file
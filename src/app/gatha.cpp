@@ -1,133 +1,228 @@
 #include "gatha.hpp"
 #include "camera.hpp"
+#include "gpu_cull.hpp"
 #include "../core/string.hpp"
 #include "../core/log.hpp"
 #include "../renderer/renderer.hpp"
+#include "../renderer/queue.hpp"
 #include "../renderer/opengl/shader.hpp"
 #include "../renderer/opengl/mesh.hpp"
+#include "../renderer/opengl/geometry.hpp"
+#include "../renderer/opengl/ring.hpp"
 #include "../renderer/opengl/texture.hpp"
 #include "../platform/platform.hpp"
 #include "../asset/asset.hpp"
 #include "../ecs/world.hpp"
+#include "../ecs/scheduler.hpp"
+#include "../ecs/hierarchy.hpp"
+#include "../ecs/sort.hpp"
+#include "../ecs/commands.hpp"
+#include "../ecs/snapshot.hpp"
+#include "../ecs/transform_columns.hpp"
+#include "../core/jobs.hpp"
+#include "../core/bits.hpp"
+#include "../core/bvh.hpp"
+#include "../core/radix.hpp"
 #include "../core/file.hpp"
 #include "../scene/scene.hpp"
 
+#include <intrin.h>
+
 namespace {
-	opengl::GLuint shader_program;
+	opengl::GLuint shader_program;  // shader_bindless when the driver has bindless textures, else shader
+	bool           bindless;        // the frame is one multi-draw; otherwise one per texture run
+	GpuCull        gpu_cull;
+	bool           gpu_culling;     // cull and build commands in shaders/cull.comp (not depth sorted, see gpu_cull.hpp); otherwise on the CPU
 	opengl::GLint  vp_loc;
-	opengl::GLint  offset_loc;
 	opengl::GLint  albedo_loc;
 	opengl::GLuint fallback_texture;
+	u64            fallback_texture_handle;
 	Camera         cam;
+	const f32      CAMERA_FOV_Y = to_radians(60.0f);
+	constexpr f32  CAMERA_NEAR = 0.1f;
+	constexpr f32  CAMERA_FAR = 1000.0f;
 
 	ecs::World     world;
+	constexpr u32  WORLD_CAPACITY = 1u << 20;
 	scene::Scene   current_scene;
+	ecs::Scheduler update_scheduler;
+	ecs::HierarchyLevels hierarchy_levels;
+	ecs::CommandQueue    world_commands; // structural changes recorded by systems, applied once per update
+
+	// Simulation of frame N+1 runs on the workers while frame N renders from the front snapshot.
+	// Anything else touching `world` waits for it first (wait_simulation).
+	ecs::RenderSnapshots render_snapshots;
+	jobs::Group          simulation_group;
+	f64                  snapshot_seconds;  // accumulated capture time since the last report
+	u32                  snapshot_captures;
+
+	bool                 display_list_dirty; // set by the hierarchy store observer
+
+	// File > Load parses into a staging world on the background queue, so frame sync points never pick
+	// the parse up themselves; update() commits it once the job is done
+	scene::SceneStage    scene_stage;
+	jobs::Group          scene_load_group;
+	char                 scene_load_path[256];
+	bool                 scene_load_pending;
 
-	// SSBO for per-instance model matrices
-	opengl::GLuint transform_ssbo;
 	constexpr u32  MAX_INSTANCES = 16384;
 
-	// Per-frame batch data
-	struct DrawBatch {
-		u32 asset_id;
-		u32 offset;
-		u32 count;
-	};
+	// Everything render() streams to the GPU each frame lives in one persistently mapped ring,
+	// written in place: per region the instance matrices (SSBO 0), one indirect command per draw,
+	// then an albedo handle per draw (SSBO 1, bindless only). A draw has at least one instance, so
+	// MAX_INSTANCES also bounds the draw count. With GPU culling the commands are per-group templates
+	// copied into gpu_cull.commands and the matrix section is unused. Section sizes are multiples of 256 bytes, the largest
+	// SSBO offset alignment GL allows.
+	opengl::StreamRing frame_ring;
+	constexpr usize    RING_MATRICES = 0;
+	constexpr usize    RING_COMMANDS = RING_MATRICES + MAX_INSTANCES * sizeof(mat3x4);
+	constexpr usize    RING_HANDLES = RING_COMMANDS + MAX_INSTANCES * sizeof(opengl::DrawElementsIndirectCommand);
+	constexpr usize    RING_REGION_SIZE = RING_HANDLES + MAX_INSTANCES * sizeof(u64);
+	static_assert(RING_COMMANDS % 256 == 0 && RING_HANDLES % 256 == 0, "ring sections must stay 256-byte aligned");
+
+	// 0..MAX_INSTANCES-1, turned into per-instance indices by the shared VAO
+	opengl::GLuint instance_id_buffer;
+
+	// Scratch for one update + render; begun at the top of update()
+	memory::FrameArena frame_arena;
+	constexpr usize    FRAME_ARENA_SIZE = 4 * 1024 * 1024;
+
+	// Debug check that update, simulation and render stay off the heap once nothing changes between
+	// frames. Sampled at the simulation join, when no job is writing the world.
+	u64            frame_allocation_base;
+	u64            frame_layout_key;     // layout versions at the previous sample
+	u32            frame_stable_count;   // samples in a row with the same layout key
 
 	arr::Array<file::FileEntry> asset_file_entries = {};
 	arr::Array<platform::EntityEntry> entity_display_list = {};
 	ecs::Entity selected_entity = ecs::INVALID_ENTITY;
 }
 
-static bool is_ancestor(ecs::Entity ancestor, ecs::Entity descendant) {
-	ecs::Entity cur = descendant;
-	for (int depth = 0; depth < 8; depth++) {
-		ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, cur);
-		if (!hn || hn->parent == ecs::INVALID_ENTITY) return false;
-		if (hn->parent == ancestor) return true;
-		cur = hn->parent;
-	}
-	return false;
+static void push_display_entry(ecs::Entity e, u32 depth) {
+	platform::EntityEntry entry = {};
+	entry.entity = e;
+	entry.depth = depth;
+
+	ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, e);
+	str::copy(entry.name, hn ? hn->name : "Entity", sizeof(entry.name));
+	arr::array_push(&entity_display_list, entry);
 }
 
-static i32 scene_index_of(ecs::Entity e) {
-	for (usize i = 0; i < current_scene.entities.count; i++) {
-		if (current_scene.entities.data[i] == e) return (i32)i;
+// Depth-first over the scene's parent links so children list directly under their parent.
+// Sibling order follows scene order.
+static void rebuild_entity_display_list() {
+	arr::array_clear(&entity_display_list);
+
+	u32 count = (u32)current_scene.entities.count;
+	u32 hierarchy_count = (u32)world.hierarchy.data.count;
+	u32* scratch = memory::frame_push<u32>(&frame_arena, hierarchy_count + count * 5);
+	u32* scene_pos = scratch;                       // by hierarchy dense index
+	u32* parent_pos = scene_pos + hierarchy_count;  // by scene index
+	u32* first_child = parent_pos + count;
+	u32* next_sibling = first_child + count;
+	u32* stack = next_sibling + count;              // pairs of (scene index, depth)
+	memory::set(scratch, 0xFF, (hierarchy_count + count * 4) * sizeof(u32));
+
+	for (u32 i = 0; i < count; i++) {
+		u32 di = ecs::sparse_get(&world.hierarchy.sparse, ecs::entity_index(current_scene.entities.data[i]));
+		if (di < hierarchy_count) scene_pos[di] = i;
 	}
-	return -1;
-}
 
-static void ensure_child_after_parent(ecs::Entity child, ecs::Entity parent) {
-	i32 child_idx = scene_index_of(child);
-	i32 parent_idx = scene_index_of(parent);
-	if (child_idx < 0 || parent_idx < 0) return;
-	if (child_idx > parent_idx) return;
+	for (u32 i = 0; i < count; i++) {
+		ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, current_scene.entities.data[i]);
+		if (!hn || !ecs::store_has(&world.hierarchy, hn->parent)) continue;
+		parent_pos[i] = scene_pos[ecs::sparse_get(&world.hierarchy.sparse, ecs::entity_index(hn->parent))];
+	}
 
-	// Remove child from current position and insert after parent
-	ecs::Entity tmp = current_scene.entities.data[child_idx];
-	for (i32 i = child_idx; i < parent_idx; i++) {
-		current_scene.entities.data[i] = current_scene.entities.data[i + 1];
+	// Link in reverse so siblings come out in scene order
+	for (u32 i = count; i-- > 0;) {
+		u32 p = parent_pos[i];
+		if (p == ecs::INVALID_INDEX) continue;
+		next_sibling[i] = first_child[p];
+		first_child[p] = i;
 	}
-	current_scene.entities.data[parent_idx] = tmp;
-}
 
-static void rebuild_entity_display_list() {
-	arr::array_clear(&entity_display_list);
-	for (usize i = 0; i < current_scene.entities.count; i++) {
-		ecs::Entity e = current_scene.entities.data[i];
-		ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, e);
-
-		platform::EntityEntry entry = {};
-		entry.entity = e;
-		entry.depth = 0;
-
-		if (hn) {
-			str::copy(entry.name, hn->name, sizeof(entry.name));
-			ecs::Entity cur = hn->parent;
-			while (cur != ecs::INVALID_ENTITY && entry.depth < 8) {
-				entry.depth++;
-				ecs::HierarchyNode* phn = ecs::store_get(&world.hierarchy, cur);
-				cur = phn ? phn->parent : ecs::INVALID_ENTITY;
+	for (u32 root = 0; root < count; root++) {
+		if (parent_pos[root] != ecs::INVALID_INDEX) continue;
+		u32 top = 0;
+		stack[top++] = root;
+		stack[top++] = 0;
+		while (top > 0) {
+			u32 depth = stack[--top];
+			u32 node = stack[--top];
+			push_display_entry(current_scene.entities.data[node], depth);
+
+			// Push children back to front so the first child pops first
+			u32 first = top;
+			for (u32 c = first_child[node]; c != ecs::INVALID_INDEX; c = next_sibling[c]) {
+				stack[top++] = c;
+				stack[top++] = depth + 1;
+			}
+			if (top - first < 4) continue; // top may be 0 here, so top - 2 would wrap
+			for (u32 a = first, b = top - 2; a < b; a += 2, b -= 2) {
+				u32 tn = stack[a], td = stack[a + 1];
+				stack[a] = stack[b]; stack[a + 1] = stack[b + 1];
+				stack[b] = tn; stack[b + 1] = td;
 			}
 		}
-		else {
-			str::copy(entry.name, "Entity", sizeof(entry.name));
-		}
-
-		arr::array_push(&entity_display_list, entry);
 	}
+
 	platform::editor_set_entity_entries(&entity_display_list);
 }
 
-static void on_parent(ecs::Entity child, ecs::Entity parent) {
-	if (child == parent) return;
-	if (is_ancestor(child, parent)) return;
-
-	ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, child);
-	if (!hn) return;
-
-	// check depth won't exceed 8
-	u32 parent_depth = 0;
-	ecs::Entity cur = parent;
-	while (cur != ecs::INVALID_ENTITY && parent_depth < 8) {
-		ecs::HierarchyNode* phn = ecs::store_get(&world.hierarchy, cur);
-		if (!phn || phn->parent == ecs::INVALID_ENTITY) break;
-		parent_depth++;
-		cur = phn->parent;
+static void wait_simulation() {
+	jobs::wait(&simulation_group);
+}
+
+// Any hierarchy add, remove or reparent invalidates the editor's entity list; it is rebuilt once in update()
+static void on_hierarchy_event(void*, ecs::Entity, u32) {
+	display_list_dirty = true;
+}
+
+static void scene_load_job(void*, u32, u32) {
+	scene::stage(&scene_stage, scene_load_path);
+}
+
+// Hands the loaded assets' local bounds to the snapshots, which build their BVHs from them.
+// Must run with the simulation idle.
+static void sync_asset_bounds() {
+	u32 count = 0;
+	while (asset::get(count)) count++;
+	AABB* bounds = memory::frame_push<AABB>(&frame_arena, count);
+	for (u32 id = 0; id < count; id++) bounds[id] = asset::get(id)->bounds;
+	ecs::render_snapshots_set_asset_bounds(&render_snapshots, bounds, count);
+}
+
+// Swaps the staged scene in for the current one. The old scene stays up until the new one is ready.
+static void commit_scene_load() {
+	if (!scene_load_pending || !jobs::done(&scene_load_group)) return;
+	scene_load_pending = false;
+	if (!scene_stage.loaded) {
+		scene::stage_destroy(&scene_stage);
+		return;
 	}
-	if (parent_depth >= 7) return;
 
-	hn->parent = parent;
-	ensure_child_after_parent(child, parent);
-	rebuild_entity_display_list();
+	selected_entity = ecs::INVALID_ENTITY;
+	platform::editor_clear_transform();
+	scene::unload(&current_scene, &world);
+	asset::shutdown();
+	ecs::render_snapshots_invalidate(&render_snapshots); // asset ids are about to be reused
+	scene::commit(&current_scene, &scene_stage, &world);
+	sync_asset_bounds();
+}
+
+static void on_parent(ecs::Entity child, ecs::Entity parent) {
+	wait_simulation();
+	ecs::hierarchy_set_parent(&world, child, parent);
 }
 
 static void on_entity_selected(ecs::Entity e) {
+	wait_simulation();
 	selected_entity = e;
 	if (e != ecs::INVALID_ENTITY) {
 		ecs::Transform* t = ecs::store_get(&world.transforms, e);
 		if (t) {
-			platform::editor_set_transform(t->position, t->rotation, t->scale);
+			platform::editor_set_transform(t->position, quat_to_euler(t->rotation), t->scale);
 			return;
 		}
 	}
@@ -136,24 +231,29 @@ static void on_entity_selected(ecs::Entity e) {
 
 static void on_transform_changed(vec3 pos, vec3 rot, vec3 scale) {
 	if (selected_entity == ecs::INVALID_ENTITY) return;
+	wait_simulation();
 	ecs::Transform* t = ecs::store_get(&world.transforms, selected_entity);
 	if (!t) return;
 	t->position = pos;
-	t->rotation = rot;
+	t->rotation = quat_from_euler(rot);
 	t->scale = scale;
+	ecs::store_mark_changed(&world.transforms, selected_entity);
 }
 
 static void on_asset_double_click(const char* path) {
+	wait_simulation();
 	i32 id = asset::load(path);
 	if (id < 0) return;
+	sync_asset_bounds();
 
 	ecs::Entity e = ecs::pool_create(&world.pool);
 	if (e == ecs::INVALID_ENTITY) return;
 
 	ecs::Transform t = {};
 	t.position = { 0.0f, 0.0f, 0.0f };
+	t.rotation = quat_identity();
 	t.scale = { 1.0f, 1.0f, 1.0f };
-	t.local_to_world = mat4_identity();
+	t.local_to_world = mat3x4_identity();
 	ecs::store_add(&world.transforms, e, t);
 	ecs::store_add(&world.mesh_instances, e, { (u32)id });
 
@@ -165,10 +265,39 @@ static void on_asset_double_click(const char* path) {
 	ecs::store_add(&world.hierarchy, e, hn);
 
 	arr::array_push(&current_scene.entities, e);
-	rebuild_entity_display_list();
+}
+
+// Right click in the viewport: selects the nearest entity whose world bounds the cursor ray hits.
+// Reads the front snapshot's BVH, which the simulation never writes.
+static void on_viewport_pick(u32 x, u32 y) {
+	u32 w, h;
+	platform::get_paint_field_size(&w, &h);
+	if (w == 0 || h == 0) return;
+	f32 ndc_x = ((f32)x + 0.5f) / (f32)w * 2.0f - 1.0f;
+	f32 ndc_y = 1.0f - ((f32)y + 0.5f) / (f32)h * 2.0f;
+
+	vec3 origin, dir;
+	camera_get_ray(&cam, CAMERA_FOV_Y, (f32)w / (f32)h, ndc_x, ndc_y, &origin, &dir);
+	vec3 inv_dir = { 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z };
+
+	const ecs::RenderSnapshot* snapshot = ecs::render_snapshot_front(&render_snapshots);
+	if (!snapshot->valid) return;
+	u32 hit = ecs::INVALID_INDEX;
+	bvh::raycast(&snapshot->tree, origin, dir, 1e30f, [&](u32 entry, f32 max_t) {
+		f32 t = ray_intersect_aabb(origin, inv_dir, snapshot->bounds.data[entry], max_t);
+		if (t < 0.0f) return max_t;
+		hit = entry;
+		return t;
+	});
+	if (hit == ecs::INVALID_INDEX) return;
+
+	ecs::Entity e = snapshot->entities.data[hit];
+	on_entity_selected(e);
+	platform::editor_select_entity(e);
 }
 
 static void on_menu(int action) {
+	wait_simulation();
 	if (action == platform::MENU_FILE_SAVE) {
 		if (current_scene.path[0]) {
 			scene::save(&current_scene, &world);
@@ -180,25 +309,172 @@ static void on_menu(int action) {
 			scene::save(&current_scene, &world);
 		}
 	} else if (action == platform::MENU_FILE_LOAD) {
-		char path[256];
-		if (platform::editor_open_file_dialog(path, sizeof(path))) {
-			selected_entity = ecs::INVALID_ENTITY;
-			platform::editor_clear_transform();
-			scene::unload(&current_scene, &world);
-			asset::shutdown();
-			scene::load(&current_scene, path, &world);
-			rebuild_entity_display_list();
+		if (scene_load_pending) {
+			logger::warn("scene: a load is already in progress");
+			return;
+		}
+		if (platform::editor_open_file_dialog(scene_load_path, sizeof(scene_load_path))) {
+			scene_load_pending = true;
+			jobs::submit_background(&scene_load_group, scene_load_job, nullptr);
+		}
+	}
+}
+
+static void transform_dirty_system(ecs::World* w, void* user) {
+	ecs::HierarchyLevels* levels = (ecs::HierarchyLevels*)user;
+
+	// Reparented and orphaned nodes are marked here, so this runs even when nothing else changed
+	ecs::hierarchy_levels_update(levels);
+	if (w->transforms.changed_count == 0) return;
+
+	// A moved parent moves its whole subtree
+	ecs::hierarchy_mark_descendants(levels, &w->transforms);
+}
+
+// Each changed word's transforms are composed through one TrsBlock (ecs/transform_columns.hpp).
+static void local_transform_job(void* user, u32 begin, u32 end) {
+	ecs::Store<ecs::Transform>* transforms = (ecs::Store<ecs::Transform>*)user;
+	TrsBlock block;
+	u32 dense[TRS_BLOCK];
+	for (u32 w = begin; w < end; w++) {
+		u32 count = 0;
+		ecs::store_each_changed_range(transforms, w, w + 1, [&](u32 i) { dense[count++] = i; });
+		if (count > 0) ecs::transform_compose(&block, transforms->data.data, dense, count);
+	}
+}
+
+static void local_transform_system(ecs::World* w, void*) {
+	if (w->transforms.changed_count == 0) return;
+	jobs::parallel_for((u32)w->transforms.changed.count, 4, local_transform_job, &w->transforms);
+}
+
+static void hierarchy_system(ecs::World* w, void* user) {
+	if (w->transforms.changed_count == 0) return;
+	ecs::hierarchy_propagate((const ecs::HierarchyLevels*)user, &w->transforms);
+}
+
+static void simulation_job(void*, u32, u32) {
+	ecs::scheduler_run(&update_scheduler, &world);
+
+	f64 start = platform::get_time();
+	ecs::render_snapshots_capture(&render_snapshots, &world);
+	snapshot_seconds += platform::get_time() - start;
+	snapshot_captures++;
+
+	ecs::store_clear_changed(&world.transforms);
+}
+
+// Tests boundary entries (leaves the BVH walk could not accept whole) against their exact bounds,
+// gathered into columns 64 at a time and checked 8 at a time.
+static void cull_boundary(const ecs::RenderSnapshot* snapshot, const Frustum& frustum, const u32* entries, u32 count, u64* visible) {
+	f32 cx[64], cy[64], cz[64], ex[64], ey[64], ez[64];
+	for (u32 base = 0; base < count; base += 64) {
+		u32 n = count - base < 64 ? count - base : 64;
+		for (u32 i = 0; i < n; i++) {
+			const AABB& b = snapshot->bounds.data[entries[base + i]];
+			cx[i] = (b.min.x + b.max.x) * 0.5f; ex[i] = (b.max.x - b.min.x) * 0.5f;
+			cy[i] = (b.min.y + b.max.y) * 0.5f; ey[i] = (b.max.y - b.min.y) * 0.5f;
+			cz[i] = (b.min.z + b.max.z) * 0.5f; ez[i] = (b.max.z - b.min.z) * 0.5f;
+		}
+		u64 inside = frustum_test_boxes(frustum, cx, cy, cz, ex, ey, ez, n);
+		while (inside) {
+			u32 i = bits::ctz64(inside);
+			inside &= inside - 1;
+			bits::set(visible, entries[base + i]);
+		}
+	}
+}
+
+// CPU path: cull through the snapshot's BVH, sort the visible instances and write their matrices,
+// commands and handles into the ring region. Returns the draw count; *instance_count is how many
+// matrices were written.
+static u32 queue_cpu_draws(const ecs::RenderSnapshot* snapshot, const mat4& view, const Frustum& frustum,
+	byte* region, opengl::GLuint* draw_textures, u32* instance_count_out) {
+	u32 mesh_count = (u32)snapshot->asset_ids.count;
+
+	// Walk the snapshot's BVH: subtrees fully inside the frustum are accepted without further tests,
+	// leaves on the boundary are checked against their exact bounds. The batch pass reads the mask.
+	u32 mask_words = bits::word_count(mesh_count);
+	u64* visible = memory::frame_push<u64>(&frame_arena, mask_words);
+	memory::set(visible, 0, mask_words * sizeof(u64));
+	u32* boundary = memory::frame_push<u32>(&frame_arena, mesh_count);
+	u32 boundary_count = 0;
+	bvh::query_frustum(&snapshot->tree, frustum, [&](u32 entry, bool inside) {
+		if (inside) bits::set(visible, entry);
+		else boundary[boundary_count++] = entry;
+	});
+	cull_boundary(snapshot, frustum, boundary, boundary_count, visible);
+
+	// Queue a sort key per visible instance; the state bits are resolved once per asset group
+	u64* keys = memory::frame_push<u64>(&frame_arena, mesh_count);
+	u32* entries = memory::frame_push<u32>(&frame_arena, mesh_count);
+	u32 queued = 0;
+	for (usize g = 0; g < snapshot->groups.count; g++) {
+		const ecs::KeyRange& range = snapshot->groups.data[g];
+		asset::Asset* a = asset::get(range.key);
+		if (!a) continue;
+		u64 state = renderer::queue_state(shader_program, a->texture ? a->texture : fallback_texture, range.key);
+		for (u32 i = range.begin; i < range.begin + range.count; i++) {
+			if (!bits::test(visible, i)) continue;
+			const AABB& b = snapshot->bounds.data[i];
+			vec3 c = { (b.min.x + b.max.x) * 0.5f, (b.min.y + b.max.y) * 0.5f, (b.min.z + b.max.z) * 0.5f };
+			f32 depth = -(view.col[0][2] * c.x + view.col[1][2] * c.y + view.col[2][2] * c.z + view.col[3][2]);
+			keys[queued] = state | renderer::queue_depth(depth, CAMERA_FAR);
+			entries[queued] = i;
+			queued++;
+		}
+	}
+	u64* temp_keys = memory::frame_push<u64>(&frame_arena, queued);
+	u32* temp_entries = memory::frame_push<u32>(&frame_arena, queued);
+	radix::sort_u64_parallel(keys, entries, temp_keys, temp_entries, queued);
+
+	// Runs of equal state become indirect draws, their instances front to back. base_instance is
+	// the draw's first slot in the matrix section. Everything is written straight into this frame's
+	// ring region, once and in order (the mapping is write-combined, never read it back).
+	u32 instance_count = queued < MAX_INSTANCES ? queued : MAX_INSTANCES;
+	mat3x4* matrices = (mat3x4*)(region + RING_MATRICES);
+	opengl::DrawElementsIndirectCommand* commands = (opengl::DrawElementsIndirectCommand*)(region + RING_COMMANDS);
+	u64* draw_handles = (u64*)(region + RING_HANDLES);
+	u32 draw_count = 0;
+	opengl::DrawElementsIndirectCommand command = {};
+	for (u32 k = 0; k < instance_count; k++) {
+		u32 entry = entries[k];
+		matrices[k] = snapshot->models.data[entry];
+		if (k > 0 && renderer::queue_key_state(keys[k]) == renderer::queue_key_state(keys[k - 1])) {
+			command.instance_count++;
+			continue;
 		}
+		if (k > 0) commands[draw_count - 1] = command;
+		const asset::Asset* a = asset::get(snapshot->asset_ids.data[entry]);
+		command = { a->index_count, 1, a->first_index, a->base_vertex, k };
+		draw_textures[draw_count] = a->texture ? a->texture : fallback_texture;
+		if (bindless) draw_handles[draw_count] = a->texture ? a->texture_handle : fallback_texture_handle;
+		draw_count++;
 	}
+	if (draw_count > 0) commands[draw_count - 1] = command;
+	*instance_count_out = instance_count;
+	return draw_count;
 }
 
-static mat4 transform_to_mat4(const ecs::Transform& t) {
-	mat4 m = mat4_translate(t.position);
-	m = m * mat4_rotate(t.rotation.x, { 0, 1, 0 });
-	m = m * mat4_rotate(t.rotation.y, { 1, 0, 0 });
-	m = m * mat4_rotate(t.rotation.z, { 0, 0, 1 });
-	m = m * mat4_scale(t.scale);
-	return m;
+// GPU path: bring the resident instance data up to date and write one command template per
+// snapshot group; gpu_cull_dispatch fills in the instance counts. Assets that aren't loaded get
+// an empty command so command indices stay equal to group indices.
+static u32 queue_gpu_draws(const ecs::RenderSnapshot* snapshot, byte* region, opengl::GLuint* draw_textures) {
+	gpu_cull_sync(&gpu_cull, snapshot, &frame_arena);
+
+	opengl::DrawElementsIndirectCommand* commands = (opengl::DrawElementsIndirectCommand*)(region + RING_COMMANDS);
+	u64* draw_handles = (u64*)(region + RING_HANDLES);
+	u32 draw_count = (u32)snapshot->groups.count < MAX_INSTANCES ? (u32)snapshot->groups.count : MAX_INSTANCES;
+	for (u32 g = 0; g < draw_count; g++) {
+		const ecs::KeyRange& range = snapshot->groups.data[g];
+		const asset::Asset* a = asset::get(range.key);
+		opengl::DrawElementsIndirectCommand command = { 0, 0, 0, 0, range.begin };
+		if (a) command = { a->index_count, 0, a->first_index, a->base_vertex, range.begin };
+		commands[g] = command;
+		draw_textures[g] = a && a->texture ? a->texture : fallback_texture;
+		if (bindless) draw_handles[g] = a && a->texture ? a->texture_handle : fallback_texture_handle;
+	}
+	return draw_count;
 }
 
 bool init() {
@@ -208,24 +484,43 @@ bool init() {
 	platform::editor_set_parent_callback(on_parent);
 	platform::editor_set_entity_callback(on_entity_selected);
 	platform::editor_set_transform_callback(on_transform_changed);
+	platform::editor_set_pick_callback(on_viewport_pick);
 
 	u32 w, h;
 	platform::get_paint_field_size(&w, &h);
 	renderer::init(platform::get_native_window_handle(), w, h);
 	opengl::shader_load("shaders");
-	shader_program = opengl::shader_get("shader");
+	shader_program = 0;
+	if (opengl::glGetTextureHandleARB) {
+		opengl::shader_load("shaders/bindless");
+		shader_program = opengl::shader_get("shader_bindless");
+	}
+	bindless = shader_program != 0;
+	if (!bindless) shader_program = opengl::shader_get("shader");
+	logger::info("render: %s", bindless ? "bindless textures, one multi-draw per frame" : "one multi-draw per texture");
 	vp_loc = opengl::glGetUniformLocation(shader_program, "u_vp");
-	offset_loc = opengl::glGetUniformLocation(shader_program, "u_instance_offset");
 	albedo_loc = opengl::glGetUniformLocation(shader_program, "u_albedo");
 	fallback_texture = opengl::texture_create_solid(255, 0, 255, 255);
-
-	// Create SSBO with GL_DYNAMIC_STORAGE_BIT so we can update it each frame
-	opengl::glCreateBuffers(1, &transform_ssbo);
-	opengl::glNamedBufferStorage(transform_ssbo,
-		MAX_INSTANCES * sizeof(mat4), nullptr,
-		opengl::GL_DYNAMIC_STORAGE_BIT);
-
-	ecs::world_init(&world);
+	fallback_texture_handle = opengl::texture_make_resident(fallback_texture);
+	memory::frame_arena_init(&frame_arena, FRAME_ARENA_SIZE);
+
+	opengl::ring_init(&frame_ring, RING_REGION_SIZE);
+	instance_id_buffer = opengl::instance_ids_create(MAX_INSTANCES);
+	gpu_culling = gpu_cull_init(&gpu_cull, MAX_INSTANCES);
+	logger::info("render: %s culling", gpu_culling ? "compute shader" : "CPU");
+
+	ecs::world_init(&world, WORLD_CAPACITY);
+	ecs::store_observe(&world.hierarchy, on_hierarchy_event, nullptr);
+	ecs::hierarchy_levels_init(&hierarchy_levels, &world);
+
+	jobs::init();
+	ecs::scheduler_add(&update_scheduler, "transform_dirty", transform_dirty_system, &hierarchy_levels,
+		ecs::component_mask<ecs::HierarchyNode>(), ecs::component_mask<ecs::Transform>());
+	ecs::scheduler_add(&update_scheduler, "local_transforms", local_transform_system, nullptr,
+		0, ecs::component_mask<ecs::Transform>());
+	ecs::scheduler_add(&update_scheduler, "hierarchy", hierarchy_system, &hierarchy_levels,
+		ecs::component_mask<ecs::HierarchyNode>(), ecs::component_mask<ecs::Transform>());
+	ecs::scheduler_build(&update_scheduler);
 
 	camera_init(&cam, { 0.0f, 1.0f, 5.0f }, 5.0f, 0.002f);
 
@@ -235,7 +530,40 @@ bool init() {
 	return true;
 }
 
+// Everything a frame's allocations legitimately depend on: world layout, snapshot layout, assets,
+// and frame arena growth. Frames that start with the same key as the last two must not allocate.
+static u64 frame_layout() {
+	u64 key = world.transforms.version;
+	key = key * 31 + world.mesh_instances.version;
+	key = key * 31 + world.hierarchy.version;
+	key = key * 31 + world.hidden.version;
+	key = key * 31 + render_snapshots.layout;
+	key = key * 31 + render_snapshots.asset_bounds.count;
+	key = key * 31 + frame_arena.grow_count;
+	return key;
+}
+
+// Call right after wait_simulation(). Checks the window since the previous call (the rest of that
+// update, the simulation it started, the render and the start of this update), then opens the next.
+// A background scene load allocates on a worker meanwhile, so those windows are skipped. Debug
+// builds stop in the debugger on the first steady-state allocation.
+static void frame_allocations_check() {
+	u64 key = frame_layout();
+	u64 count = memory::allocation_count();
+#ifndef NDEBUG
+	u64 allocations = count - frame_allocation_base;
+	if (allocations > 0 && frame_stable_count >= 2 && key == frame_layout_key && !scene_load_pending) {
+		logger::error("frame: %llu heap allocations in a steady-state update + simulation + render", allocations);
+		__debugbreak();
+	}
+#endif
+	frame_stable_count = key == frame_layout_key ? frame_stable_count + 1 : 0;
+	frame_layout_key = key;
+	frame_allocation_base = count;
+}
+
 void update() {
+	memory::frame_begin(&frame_arena);
 	f32 dt = platform::get_delta_time();
 
 	static f32 f5_cooldown = 0.0f;
@@ -259,6 +587,18 @@ void update() {
 		esc_cooldown = 0.3f;
 	}
 
+	static f32 snapshot_report = 0.0f;
+	snapshot_report += dt;
+	if (snapshot_report >= 5.0f && snapshot_captures > 0) {
+		u32 entities = (u32)ecs::render_snapshot_front(&render_snapshots)->asset_ids.count;
+		f64 ms = snapshot_seconds * 1000.0 / snapshot_captures;
+		logger::info("snapshot: %.3f ms per capture, %u entities (%.3f ms per 10K)",
+			ms, entities, entities ? ms * 10000.0 / entities : 0.0);
+		snapshot_seconds = 0.0;
+		snapshot_captures = 0;
+		snapshot_report = 0.0f;
+	}
+
 	if (platform::is_editor_mode()) {
 		static f32 fps_accum = 0.0f;
 		static u32 fps_frames = 0;
@@ -276,22 +616,18 @@ void update() {
 		camera_update(&cam, dt);
 	}
 
-	for (usize i = 0; i < world.transforms.data.count; i++) {
-		world.transforms.data.data[i].local_to_world = transform_to_mat4(world.transforms.data.data[i]);
-	}
-
-	// Parent chain: parents precede children in scene entity list
-	for (usize i = 0; i < current_scene.entities.count; i++) {
-		ecs::Entity e = current_scene.entities.data[i];
-		ecs::HierarchyNode* hn = ecs::store_get(&world.hierarchy, e);
-		if (!hn || hn->parent == ecs::INVALID_ENTITY) continue;
-
-		ecs::Transform* t = ecs::store_get(&world.transforms, e);
-		ecs::Transform* pt = ecs::store_get(&world.transforms, hn->parent);
-		if (t && pt) {
-			t->local_to_world = pt->local_to_world * t->local_to_world;
-		}
+	// Sync point: join the frame simulated during the last render and publish its snapshot, land the
+	// structural changes recorded since then, and only then start simulating the next frame
+	wait_simulation();
+	frame_allocations_check();
+	ecs::render_snapshots_swap(&render_snapshots);
+	ecs::commands_apply(&world_commands, &world);
+	commit_scene_load();
+	if (display_list_dirty) {
+		rebuild_entity_display_list();
+		display_list_dirty = false;
 	}
+	jobs::submit(&simulation_group, simulation_job, nullptr, 0, 1);
 }
 
 void render() {
@@ -301,117 +637,99 @@ void render() {
 	renderer::begin_frame();
 	f32 aspect = (h > 0) ? (f32)w / (f32)h : 1.0f;
 	mat4 view = camera_get_view(&cam);
-	mat4 proj = mat4_perspective(to_radians(60.0f), aspect, 0.1f, 1000.0f);
+	mat4 proj = mat4_perspective(CAMERA_FOV_Y, aspect, CAMERA_NEAR, CAMERA_FAR);
 	mat4 vp = proj * view;
 
 	Frustum frustum = frustum_from_vp(vp);
 
-	u32 instance_count = (u32)world.mesh_instances.data.count;
-	if (instance_count == 0) { renderer::end_frame(); return; }
-	if (instance_count > MAX_INSTANCES) instance_count = MAX_INSTANCES;
-
-	arr::Array<DrawBatch> batches = {};
-	mat4* matrices = (mat4*)memory::malloc(instance_count * sizeof(mat4));
-
-	// Pass 1: cull and count visible instances per asset
-	for (usize i = 0; i < instance_count; i++) {
-		ecs::Entity e = world.mesh_instances.entities.data[i];
-		u32 aid = world.mesh_instances.data.data[i].asset_id;
-
-		ecs::Transform* t = ecs::store_get(&world.transforms, e);
-		mat4 model = t ? t->local_to_world : mat4_identity();
-
-		asset::Asset* a = asset::get(aid);
-		if (!a) continue;
-
-		AABB world_bounds = aabb_transform(a->bounds, model);
-		if (!frustum_test_aabb(frustum, world_bounds)) continue;
-
-		DrawBatch* batch = nullptr;
-		for (usize b = 0; b < batches.count; b++) {
-			if (batches.data[b].asset_id == aid) { batch = &batches.data[b]; break; }
-		}
-		if (!batch) {
-			arr::array_push(&batches, DrawBatch{ aid, 0, 0 });
-			batch = &batches.data[batches.count - 1];
-		}
-		batch->count++;
+	// Only the front snapshot is read here; the world belongs to the simulation job
+	const ecs::RenderSnapshot* snapshot = ecs::render_snapshot_front(&render_snapshots);
+	u32 mesh_count = (u32)snapshot->asset_ids.count;
+	if (mesh_count == 0) { renderer::end_frame(); return; }
+
+	byte* region = opengl::ring_begin(&frame_ring);
+	usize region_offset = opengl::ring_offset(&frame_ring);
+	opengl::GLuint* draw_textures = memory::frame_push<opengl::GLuint>(&frame_arena, snapshot->groups.count);
+	u32 instance_count = 0;
+	u32 draw_count = gpu_culling
+		? queue_gpu_draws(snapshot, region, draw_textures)
+		: queue_cpu_draws(snapshot, view, frustum, region, draw_textures, &instance_count);
+
+	if (draw_count == 0) {
+		opengl::ring_end(&frame_ring);
+		renderer::end_frame();
+		return;
 	}
-
-	// Assign offsets
-	u32 running_offset = 0;
-	for (usize b = 0; b < batches.count; b++) {
-		batches.data[b].offset = running_offset;
-		running_offset += batches.data[b].count;
+	opengl::ring_flush(&frame_ring, RING_MATRICES, instance_count * sizeof(mat3x4));
+	opengl::ring_flush(&frame_ring, RING_COMMANDS, draw_count * sizeof(opengl::DrawElementsIndirectCommand));
+	if (bindless) opengl::ring_flush(&frame_ring, RING_HANDLES, draw_count * sizeof(u64));
+
+	// Every asset lives in the shared geometry buffer, so one VAO serves the whole frame. On the GPU
+	// path the instance attribute comes from the cull pass's visible list, which holds entry
+	// indices into the resident models; otherwise it counts through this frame's matrices.
+	const opengl::GeometryBuffer* geometry = asset::geometry();
+	usize commands_offset;
+	if (gpu_culling) {
+		gpu_cull_dispatch(&gpu_cull, frustum, frame_ring.buffer, region_offset + RING_COMMANDS, draw_count);
+		opengl::geometry_bind_instance_ids(geometry, gpu_cull.visible);
+		opengl::glBindBuffer(opengl::GL_DRAW_INDIRECT_BUFFER, gpu_cull.commands);
+		opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 0, gpu_cull.models,
+			0, (opengl::GLsizeiptr)(gpu_cull.entry_count * sizeof(mat3x4)));
+		commands_offset = 0;
+	} else {
+		opengl::geometry_bind_instance_ids(geometry, instance_id_buffer);
+		opengl::glBindBuffer(opengl::GL_DRAW_INDIRECT_BUFFER, frame_ring.buffer);
+		opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 0, frame_ring.buffer,
+			(opengl::GLintptr)(region_offset + RING_MATRICES), (opengl::GLsizeiptr)(instance_count * sizeof(mat3x4)));
+		commands_offset = region_offset + RING_COMMANDS;
 	}
-
-	// Pass 2: fill matrices for visible instances
-	u32* fill_counts = (u32*)memory::malloc(batches.count * sizeof(u32));
-	memory::set(fill_counts, 0, batches.count * sizeof(u32));
-
-	for (usize i = 0; i < instance_count; i++) {
-		ecs::Entity e = world.mesh_instances.entities.data[i];
-		u32 aid = world.mesh_instances.data.data[i].asset_id;
-
-		ecs::Transform* t = ecs::store_get(&world.transforms, e);
-		mat4 model = t ? t->local_to_world : mat4_identity();
-
-		asset::Asset* a = asset::get(aid);
-		if (!a) continue;
-
-		AABB world_bounds = aabb_transform(a->bounds, model);
-		if (!frustum_test_aabb(frustum, world_bounds)) continue;
-
-		usize batch_idx = 0;
-		for (usize b = 0; b < batches.count; b++) {
-			if (batches.data[b].asset_id == aid) { batch_idx = b; break; }
-		}
-
-		u32 dst = batches.data[batch_idx].offset + fill_counts[batch_idx];
-		matrices[dst] = model;
-		fill_counts[batch_idx]++;
-	}
-
-	memory::free(fill_counts);
-
-	// Upload all transforms in one call
-	opengl::glNamedBufferSubData(transform_ssbo, 0,
-		running_offset * sizeof(mat4), matrices);
-	memory::free(matrices);
-
-	// Bind SSBO and shader, set VP matrix once
-	opengl::glBindBufferBase(opengl::GL_SHADER_STORAGE_BUFFER, 0, transform_ssbo);
+	opengl::glBindVertexArray(geometry->vao);
 	opengl::glUseProgram(shader_program);
 	opengl::glUniformMatrix4fv(vp_loc, 1, opengl::GL_FALSE, &vp.col[0][0]);
-	opengl::glUniform1i(albedo_loc, 0);
 
-	for (usize b = 0; b < batches.count; b++) {
-		asset::Asset* a = asset::get(batches.data[b].asset_id);
-		if (!a) continue;
-
-		opengl::GLuint tex = a->texture ? a->texture : fallback_texture;
-		opengl::glBindTextureUnit(0, tex);
-		opengl::glUniform1ui(offset_loc, batches.data[b].offset);
-		opengl::glBindVertexArray(a->vao);
-		opengl::glDrawElementsInstanced(opengl::GL_TRIANGLES,
-			a->index_count, opengl::GL_UNSIGNED_INT,
-			nullptr, batches.data[b].count);
+	if (bindless) {
+		opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 1, frame_ring.buffer,
+			(opengl::GLintptr)(region_offset + RING_HANDLES), (opengl::GLsizeiptr)(draw_count * sizeof(u64)));
+		opengl::glMultiDrawElementsIndirect(opengl::GL_TRIANGLES, opengl::GL_UNSIGNED_INT,
+			(const void*)commands_offset, (opengl::GLsizei)draw_count, 0);
+	} else {
+		// Without bindless handles the albedo is a bound unit: one multi-draw per run of equal texture
+		opengl::glUniform1i(albedo_loc, 0);
+		for (u32 first = 0; first < draw_count;) {
+			u32 last = first + 1;
+			while (last < draw_count && draw_textures[last] == draw_textures[first]) last++;
+			opengl::glBindTextureUnit(0, draw_textures[first]);
+			opengl::glMultiDrawElementsIndirect(opengl::GL_TRIANGLES, opengl::GL_UNSIGNED_INT,
+				(const void*)(commands_offset + first * sizeof(opengl::DrawElementsIndirectCommand)), (opengl::GLsizei)(last - first), 0);
+			first = last;
+		}
 	}
+	opengl::ring_end(&frame_ring);
 
-	arr::array_destroy(&batches);
 	renderer::end_frame();
 }
 
 void shutdown() {
+	wait_simulation();
+	jobs::wait(&scene_load_group);
+	scene::stage_destroy(&scene_stage);
 	platform::set_mouse_captured(false);
 	platform::editor_set_entity_entries(nullptr);
 	arr::array_destroy(&entity_display_list);
 	platform::editor_set_asset_entries(nullptr);
 	arr::array_destroy(&asset_file_entries);
 	scene::unload(&current_scene, &world);
+	ecs::hierarchy_levels_destroy(&hierarchy_levels);
+	ecs::render_snapshots_destroy(&render_snapshots);
+	ecs::command_queue_destroy(&world_commands);
 	ecs::world_destroy(&world);
-	opengl::glDeleteBuffers(1, &transform_ssbo);
+	jobs::shutdown();
+	opengl::ring_destroy(&frame_ring);
+	opengl::glDeleteBuffers(1, &instance_id_buffer);
+	gpu_cull_destroy(&gpu_cull);
+	opengl::texture_make_non_resident(fallback_texture_handle);
 	opengl::texture_destroy(fallback_texture);
+	memory::frame_arena_destroy(&frame_arena);
 	asset::shutdown();
 	opengl::shader_unload();
 }
@@ -0,0 +1,102 @@
+#include "gpu_cull.hpp"
+#include "../core/bits.hpp"
+#include "../renderer/opengl/shader.hpp"
+
+static void create_storage(opengl::GLuint* buffer, usize size) {
+	if (*buffer) opengl::glDeleteBuffers(1, buffer);
+	opengl::glCreateBuffers(1, buffer);
+	opengl::glNamedBufferStorage(*buffer, (opengl::GLsizeiptr)size, nullptr, opengl::GL_DYNAMIC_STORAGE_BIT);
+}
+
+static void upload_entries(GpuCull* cull, const ecs::RenderSnapshot* snapshot, u32 begin, u32 end) {
+	opengl::glNamedBufferSubData(cull->models, (opengl::GLintptr)(begin * sizeof(mat3x4)), (opengl::GLsizeiptr)((end - begin) * sizeof(mat3x4)), snapshot->models.data + begin);
+	opengl::glNamedBufferSubData(cull->bounds, (opengl::GLintptr)(begin * sizeof(AABB)), (opengl::GLsizeiptr)((end - begin) * sizeof(AABB)), snapshot->bounds.data + begin);
+}
+
+bool gpu_cull_init(GpuCull* cull, u32 max_commands) {
+	*cull = {};
+	if (!opengl::glDispatchCompute || !opengl::glMemoryBarrier || !opengl::glUniform4fv) return false;
+	cull->program = opengl::shader_get("cull");
+	if (!cull->program) return false;
+	cull->planes_loc = opengl::glGetUniformLocation(cull->program, "u_planes");
+	cull->count_loc = opengl::glGetUniformLocation(cull->program, "u_count");
+	cull->max_commands = max_commands;
+	create_storage(&cull->commands, max_commands * sizeof(opengl::DrawElementsIndirectCommand));
+	return true;
+}
+
+void gpu_cull_destroy(GpuCull* cull) {
+	opengl::GLuint buffers[] = { cull->models, cull->bounds, cull->entry_groups, cull->visible, cull->commands };
+	for (opengl::GLuint buffer : buffers) {
+		if (buffer) opengl::glDeleteBuffers(1, &buffer);
+	}
+	*cull = {};
+}
+
+void gpu_cull_sync(GpuCull* cull, const ecs::RenderSnapshot* snapshot, memory::FrameArena* arena) {
+	u32 count = (u32)snapshot->asset_ids.count;
+	cull->uploaded_pages = 0;
+	if (cull->capture == snapshot->capture && cull->entry_count == count) return;
+
+	u32 page_count = (count + ecs::SNAPSHOT_PAGE_SIZE - 1) >> ecs::SNAPSHOT_PAGE_BITS;
+	bool partial = cull->capture != 0 && cull->capture + 1 == snapshot->capture
+		&& !snapshot->full_copy && cull->entry_count == count;
+	if (partial) {
+		// Consecutive captures differ only in the pages the later one copied; send them in runs
+		const u64* pages = snapshot->copied_pages.data;
+		for (u32 page = 0; page < page_count;) {
+			if (!bits::test(pages, page)) { page++; continue; }
+			u32 end = page + 1;
+			while (end < page_count && bits::test(pages, end)) end++;
+			u32 last = end << ecs::SNAPSHOT_PAGE_BITS;
+			upload_entries(cull, snapshot, page << ecs::SNAPSHOT_PAGE_BITS, last < count ? last : count);
+			cull->uploaded_pages += end - page;
+			page = end;
+		}
+	} else if (count > 0) {
+		if (count > cull->capacity) {
+			u32 capacity = cull->capacity ? cull->capacity * 2 : 1024;
+			while (capacity < count) capacity *= 2;
+			create_storage(&cull->models, capacity * sizeof(mat3x4));
+			create_storage(&cull->bounds, capacity * sizeof(AABB));
+			create_storage(&cull->entry_groups, capacity * sizeof(u32));
+			create_storage(&cull->visible, capacity * sizeof(u32));
+			cull->capacity = capacity;
+		}
+		upload_entries(cull, snapshot, 0, count);
+
+		// Command index per entry: its group, unless the entry has no bounds or the group doesn't fit
+		u32* entry_groups = memory::frame_push<u32>(arena, count);
+		memory::set(entry_groups, 0xFF, count * sizeof(u32));
+		u32 group_count = (u32)snapshot->groups.count < cull->max_commands ? (u32)snapshot->groups.count : cull->max_commands;
+		for (u32 g = 0; g < group_count; g++) {
+			const ecs::KeyRange& range = snapshot->groups.data[g];
+			for (u32 i = range.begin; i < range.begin + range.count; i++) {
+				if (snapshot->proxies.data[i] != bvh::NULL_NODE) entry_groups[i] = g;
+			}
+		}
+		opengl::glNamedBufferSubData(cull->entry_groups, 0, (opengl::GLsizeiptr)(count * sizeof(u32)), entry_groups);
+		cull->uploaded_pages = page_count;
+	}
+	cull->entry_count = count;
+	cull->capture = snapshot->capture;
+}
+
+void gpu_cull_dispatch(GpuCull* cull, const Frustum& frustum, opengl::GLuint source_buffer, usize source_offset, u32 count) {
+	if (count > cull->max_commands) count = cull->max_commands;
+	opengl::glCopyNamedBufferSubData(source_buffer, cull->commands, (opengl::GLintptr)source_offset, 0, (opengl::GLsizeiptr)(count * sizeof(opengl::DrawElementsIndirectCommand)));
+	if (cull->entry_count == 0 || count == 0) return;
+
+	opengl::glUseProgram(cull->program);
+	opengl::glUniform4fv(cull->planes_loc, 6, &frustum.planes[0].x);
+	opengl::glUniform1ui(cull->count_loc, cull->entry_count);
+	opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 0, cull->bounds, 0, (opengl::GLsizeiptr)(cull->entry_count * sizeof(AABB)));
+	opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 1, cull->entry_groups, 0, (opengl::GLsizeiptr)(cull->entry_count * sizeof(u32)));
+	opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 2, cull->commands, 0, (opengl::GLsizeiptr)(count * sizeof(opengl::DrawElementsIndirectCommand)));
+	opengl::glBindBufferRange(opengl::GL_SHADER_STORAGE_BUFFER, 3, cull->visible, 0, (opengl::GLsizeiptr)(cull->entry_count * sizeof(u32)));
+	opengl::glDispatchCompute((cull->entry_count + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+
+	// Draws read the counts as indirect commands and `visible` as a vertex attribute; next frame's
+	// template copy overwrites what the shader wrote
+	opengl::glMemoryBarrier(opengl::GL_COMMAND_BARRIER_BIT | opengl::GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | opengl::GL_BUFFER_UPDATE_BARRIER_BIT);
+}
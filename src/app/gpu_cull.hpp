@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../core/math.hpp"
+#include "../core/memory.hpp"
+#include "../renderer/opengl/opengl.hpp"
+#include "../ecs/snapshot.hpp"
+
+// Frustum culling and indirect command generation on the GPU. The front snapshot's models and
+// bounds stay resident in SSBOs, re-sent by page as captures change them. Per frame the CPU copies
+// one command template per snapshot group (instance_count 0, base_instance = group begin) into
+// `commands` and dispatches shaders/cull.comp: every visible entry takes a slot in its group's
+// command with an atomic add and writes its entry index to `visible` at base_instance + slot.
+//
+// Bound as the geometry's instance id buffer, `visible` hands the vertex shader the entry index
+// for each drawn instance, so the same shaders index the resident models directly.
+//
+// Unlike the CPU path, draws here are not depth sorted. The CPU queue (renderer/queue.hpp) draws
+// each batch front to back so early-Z rejects hidden fragments. Here an entry's slot is whichever
+// order the atomics resolve in, and commands follow snapshot group order, so scenes with heavy
+// overdraw shade more fragments on this path. Getting the order back needs a per-group depth sort
+// of `visible` after the cull dispatch, or a depth prepass.
+//
+// tests/gpu_cull/run.sh checks this path against the CPU on any Mesa driver, llvmpipe included.
+struct GpuCull {
+	opengl::GLuint program;
+	opengl::GLint  planes_loc;
+	opengl::GLint  count_loc;
+	opengl::GLuint models;       // mat3x4 per entry
+	opengl::GLuint bounds;       // AABB per entry, world space
+	opengl::GLuint entry_groups; // command index per entry, GPU_CULL_NOT_DRAWN for entries not drawn
+	opengl::GLuint visible;      // entry index per instance slot
+	opengl::GLuint commands;     // DrawElementsIndirectCommand per command
+	u32            capacity;     // entries the per-entry buffers hold
+	u32            max_commands;
+	u32            entry_count;
+	u32            capture;      // snapshot capture the resident data matches, 0 for none
+	u32            uploaded_pages; // pages sent by the last sync
+};
+
+constexpr u32 GPU_CULL_NOT_DRAWN = 0xFFFFFFFFu;
+constexpr u32 GPU_CULL_GROUP_SIZE = 64; // local_size_x in cull.comp
+
+// False when the driver can't run compute shaders or "cull" didn't compile.
+bool gpu_cull_init(GpuCull* cull, u32 max_commands);
+void gpu_cull_destroy(GpuCull* cull);
+// Brings the resident buffers up to date with snapshot. Entries of groups at or past max_commands
+// are not drawn. Scratch comes from arena.
+void gpu_cull_sync(GpuCull* cull, const ecs::RenderSnapshot* snapshot, memory::FrameArena* arena);
+// Copies count command templates from source_buffer at source_offset, one per snapshot group, culls
+// every entry against frustum and leaves `commands` and `visible` ready for drawing.
+void gpu_cull_dispatch(GpuCull* cull, const Frustum& frustum, opengl::GLuint source_buffer, usize source_offset, u32 count);
@@ -7,13 +7,16 @@
 #include "../core/memory.hpp"
 #include "../core/string.hpp"
 #include "../core/array.hpp"
-#include "../renderer/opengl/mesh.hpp"
 #include "../renderer/opengl/texture.hpp"
 
 namespace asset {
 
 	namespace {
 		arr::Array<Asset> registry;
+		opengl::GeometryBuffer shared_geometry;
+
+		constexpr u32 GEOMETRY_VERTICES = 256 * 1024; // initial capacity, grows as needed
+		constexpr u32 GEOMETRY_INDICES = 1024 * 1024;
 	}
 
 	static void extract_name(const char* filepath, char* out, usize out_size) {
@@ -86,24 +89,29 @@ namespace asset {
 		return nullptr;
 	}
 
-	i32 load(const char* filepath) {
+	static i32 find_path(const char* filepath) {
 		for (usize i = 0; i < registry.count; i++) {
 			if (str::equal(registry.data[i].path, filepath)) return (i32)i;
 		}
+		return -1;
+	}
+
+	bool decode(const char* filepath, AssetData* out) {
+		*out = {};
 
 		cgltf_options options = {};
 		cgltf_data* data = nullptr;
 		cgltf_result result = cgltf_parse_file(&options, filepath, &data);
 		if (result != cgltf_result_success) {
 			logger::error("asset: failed to parse '%s' (cgltf error %d)", filepath, result);
-			return -1;
+			return false;
 		}
 
 		result = cgltf_load_buffers(&options, data, filepath);
 		if (result != cgltf_result_success) {
 			logger::error("asset: failed to load buffers for '%s' (cgltf error %d)", filepath, result);
 			cgltf_free(data);
-			return -1;
+			return false;
 		}
 
 		u32 total_vertices = 0;
@@ -125,11 +133,11 @@ namespace asset {
 		if (total_vertices == 0) {
 			logger::error("asset: '%s' has no geometry", filepath);
 			cgltf_free(data);
-			return -1;
+			return false;
 		}
 
-		arr::Array<opengl::Vertex> vertices = {};
-		arr::Array<u32> indices = {};
+		arr::Array<opengl::Vertex>& vertices = out->vertices;
+		arr::Array<u32>& indices = out->indices;
 		arr::array_reserve(&vertices, total_vertices);
 		arr::array_reserve(&indices, total_indices > 0 ? total_indices : total_vertices);
 
@@ -244,7 +252,6 @@ namespace asset {
 		memory::free(temp_indices);
 
 		// Extract texture from first material's baseColorTexture
-		opengl::GLuint texture = 0;
 		if (data->materials_count > 0) {
 			cgltf_material* mat = &data->materials[0];
 			if (mat->has_pbr_metallic_roughness &&
@@ -256,40 +263,70 @@ namespace asset {
 					extract_directory(filepath, dir, sizeof(dir));
 					char tex_path[512];
 					str::format(tex_path, sizeof(tex_path), "%s/%s", dir, uri);
-					texture = opengl::texture_load(tex_path);
+					opengl::image_load(tex_path, &out->image);
 				}
 			}
 		}
 
 		cgltf_free(data);
 
-		opengl::Mesh gpu_mesh = opengl::mesh_create(
-			vertices.data, (u32)vertices.count,
-			indices.data, (u32)indices.count
+		extract_name(filepath, out->name, sizeof(out->name));
+		str::copy(out->path, filepath, sizeof(out->path));
+		out->bounds = { bounds_min, bounds_max };
+		return true;
+	}
+
+	void data_destroy(AssetData* data) {
+		arr::array_destroy(&data->vertices);
+		arr::array_destroy(&data->indices);
+		opengl::image_free(&data->image);
+	}
+
+	i32 upload(AssetData* data) {
+		i32 existing = find_path(data->path);
+		if (existing >= 0) {
+			data_destroy(data);
+			return existing;
+		}
+
+		if (!shared_geometry.vao) opengl::geometry_init(&shared_geometry, GEOMETRY_VERTICES, GEOMETRY_INDICES);
+		opengl::GeometryRange range = opengl::geometry_add(&shared_geometry,
+			data->vertices.data, (u32)data->vertices.count,
+			data->indices.data, (u32)data->indices.count
 		);
 
 		Asset asset = {};
-		extract_name(filepath, asset.name, sizeof(asset.name));
-		str::copy(asset.path, filepath, sizeof(asset.path));
-		asset.vao = gpu_mesh.vao;
-		asset.vbo = gpu_mesh.vbo;
-		asset.ibo = gpu_mesh.ibo;
-		asset.texture = texture;
-		asset.bounds = { bounds_min, bounds_max };
-		asset.vertex_count = (u32)vertices.count;
-		asset.index_count = (u32)indices.count;
+		str::copy(asset.name, data->name, sizeof(asset.name));
+		str::copy(asset.path, data->path, sizeof(asset.path));
+		asset.texture = opengl::texture_create(&data->image);
+		asset.texture_handle = opengl::texture_make_resident(asset.texture);
+		asset.bounds = data->bounds;
+		asset.vertex_count = (u32)data->vertices.count;
+		asset.index_count = range.index_count;
+		asset.first_index = range.first_index;
+		asset.base_vertex = range.base_vertex;
 
 		i32 id = (i32)registry.count;
 		arr::array_push(&registry, asset);
 
-		logger::info("asset: loaded '%s' (verts=%u, indices=%u)", filepath, asset.vertex_count, asset.index_count);
-
-		arr::array_destroy(&vertices);
-		arr::array_destroy(&indices);
+		logger::info("asset: loaded '%s' (verts=%u, indices=%u)", asset.path, asset.vertex_count, asset.index_count);
 
+		data_destroy(data);
 		return id;
 	}
 
+	i32 load(const char* filepath) {
+		i32 existing = find_path(filepath);
+		if (existing >= 0) return existing;
+
+		AssetData data;
+		if (!decode(filepath, &data)) {
+			data_destroy(&data);
+			return -1;
+		}
+		return upload(&data);
+	}
+
 	Asset* get(u32 id) {
 		if (id >= registry.count) return nullptr;
 		return &registry.data[id];
@@ -309,13 +346,17 @@ namespace asset {
 		return -1;
 	}
 
+	const opengl::GeometryBuffer* geometry() {
+		return &shared_geometry;
+	}
+
 	void shutdown() {
 		for (usize i = 0; i < registry.count; i++) {
-			opengl::Mesh m = { registry.data[i].vao, registry.data[i].vbo, registry.data[i].ibo, registry.data[i].index_count };
-			opengl::mesh_destroy(&m);
+			opengl::texture_make_non_resident(registry.data[i].texture_handle);
 			opengl::texture_destroy(registry.data[i].texture);
 		}
 		arr::array_destroy(&registry);
+		if (shared_geometry.vao) opengl::geometry_destroy(&shared_geometry);
 		logger::info("asset: shutdown");
 	}
 
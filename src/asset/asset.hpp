@@ -2,25 +2,46 @@
 
 #include "../core/types.hpp"
 #include "../core/math.hpp"
+#include "../core/array.hpp"
+#include "../renderer/opengl/vertex.hpp"
+#include "../renderer/opengl/texture.hpp"
+#include "../renderer/opengl/geometry.hpp"
 
 namespace asset {
 
 	struct Asset {
 		char  name[64];
 		char  path[256];
-		u32   vao;
-		u32   vbo;
-		u32   ibo;
 		u32   texture;
+		u64   texture_handle; // resident bindless handle, 0 without GL_ARB_bindless_texture
 		AABB  bounds;
 		u32   vertex_count;
 		u32   index_count;
+		u32   first_index;    // range in geometry()
+		i32   base_vertex;
 	};
 
-	i32   load(const char* filepath);
+	// CPU side of an asset: geometry and texture decoded from disk, not yet on the GPU.
+	struct AssetData {
+		char                       name[64];
+		char                       path[256];
+		arr::Array<opengl::Vertex> vertices;
+		arr::Array<u32>            indices;
+		opengl::Image              image;
+		AABB                       bounds;
+	};
+
+	bool  decode(const char* filepath, AssetData* out); // no GL calls, safe on any thread
+	i32   upload(AssetData* data);                      // GL thread only, releases data
+	void  data_destroy(AssetData* data);
+
+	i32   load(const char* filepath); // decode + upload
 	Asset* get(u32 id);
 	Asset* find(const char* name);
 	i32   find_id(const char* name);
 	void  shutdown();
 
+	// Shared vertex/index buffers every uploaded asset lives in; vao is 0 until the first upload.
+	const opengl::GeometryBuffer* geometry();
+
 }
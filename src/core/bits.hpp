@@ -0,0 +1,43 @@
+#pragma once
+
+#include "types.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bits {
+
+	// Index of the lowest set bit. Undefined for 0.
+	inline u32 ctz64(u64 v) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, v);
+		return (u32)index;
+#else
+		return (u32)__builtin_ctzll(v);
+#endif
+	}
+
+	inline u32 popcount64(u64 v) {
+#if defined(_MSC_VER)
+		return (u32)__popcnt64(v);
+#else
+		return (u32)__builtin_popcountll(v);
+#endif
+	}
+
+	inline u32 word_count(u32 bit_count) { return (bit_count + 63) / 64; }
+
+	inline bool test(const u64* words, u32 i) { return (words[i >> 6] >> (i & 63)) & 1; }
+	inline void set(u64* words, u32 i)        { words[i >> 6] |= (1ull << (i & 63)); }
+	inline void clear(u64* words, u32 i)      { words[i >> 6] &= ~(1ull << (i & 63)); }
+
+	// Sets bits [begin, end), a word at a time.
+	inline void set_range(u64* words, u32 begin, u32 end) {
+		while (begin < end && (begin & 63)) set(words, begin++);
+		while (begin + 64 <= end) { words[begin >> 6] = ~0ull; begin += 64; }
+		while (begin < end) set(words, begin++);
+	}
+
+}
@@ -0,0 +1,344 @@
+#pragma once
+
+#include "types.hpp"
+#include "math.hpp"
+#include "array.hpp"
+
+// Dynamic AABB tree. Leaves hold a caller-provided u32 and a box fattened by `margin`, so small
+// moves are absorbed without touching the tree; a leaf that leaves its fat box is removed and
+// reinserted. Insertion picks the sibling by surface-area cost and every ancestor is refit and
+// rebalanced with AVL-style rotations on the way back up, so the height stays O(log n).
+//
+// Queries walk the tree with a fixed stack: frustum culling drops planes a node is fully inside
+// of and reports whole subtrees without further tests, ray casts clip against the closest hit.
+
+namespace bvh {
+
+	constexpr u32 NULL_NODE = ~0u;
+	constexpr u32 MAX_STACK = 256;
+
+	struct Node {
+		AABB box;
+		u32  parent;   // next free node while on the free list
+		u32  child[2]; // child[0] == NULL_NODE for leaves
+		u32  user;
+		i32  height;   // 0 for leaves
+	};
+
+	// A zero-initialized Tree is empty for queries; call init (or clear) before inserting.
+	struct Tree {
+		arr::Array<Node> nodes;
+		u32              root;
+		u32              free_list;
+		u32              leaf_count;
+		f32              margin;
+	};
+
+	inline bool is_leaf(const Node& n) { return n.child[0] == NULL_NODE; }
+
+	inline AABB box_union(const AABB& a, const AABB& b) {
+		return {
+			{ a.min.x < b.min.x ? a.min.x : b.min.x, a.min.y < b.min.y ? a.min.y : b.min.y, a.min.z < b.min.z ? a.min.z : b.min.z },
+			{ a.max.x > b.max.x ? a.max.x : b.max.x, a.max.y > b.max.y ? a.max.y : b.max.y, a.max.z > b.max.z ? a.max.z : b.max.z }
+		};
+	}
+
+	// Half the surface area; only ever compared.
+	inline f32 box_cost(const AABB& b) {
+		vec3 d = b.max - b.min;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	inline bool box_contains(const AABB& outer, const AABB& inner) {
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+			&& outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+	}
+
+	inline bool box_overlaps(const AABB& a, const AABB& b) {
+		return a.min.x <= b.max.x && a.max.x >= b.min.x
+			&& a.min.y <= b.max.y && a.max.y >= b.min.y
+			&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	inline void init(Tree* tree, f32 margin) {
+		*tree = {};
+		tree->root = NULL_NODE;
+		tree->free_list = NULL_NODE;
+		tree->margin = margin;
+	}
+
+	inline void destroy(Tree* tree) {
+		arr::array_destroy(&tree->nodes);
+		*tree = {};
+		tree->root = NULL_NODE;
+		tree->free_list = NULL_NODE;
+	}
+
+	// Drops every node, keeping the allocation.
+	inline void clear(Tree* tree) {
+		arr::array_clear(&tree->nodes);
+		tree->root = NULL_NODE;
+		tree->free_list = NULL_NODE;
+		tree->leaf_count = 0;
+	}
+
+	inline u32 alloc_node(Tree* tree) {
+		u32 i;
+		if (tree->free_list != NULL_NODE) {
+			i = tree->free_list;
+			tree->free_list = tree->nodes.data[i].parent;
+		} else {
+			i = (u32)tree->nodes.count;
+			arr::array_push(&tree->nodes, Node{});
+		}
+		Node& n = tree->nodes.data[i];
+		n = {};
+		n.parent = NULL_NODE;
+		n.child[0] = n.child[1] = NULL_NODE;
+		return i;
+	}
+
+	inline void free_node(Tree* tree, u32 i) {
+		tree->nodes.data[i].parent = tree->free_list;
+		tree->nodes.data[i].height = -1;
+		tree->free_list = i;
+	}
+
+	inline void replace_child(Tree* tree, u32 parent, u32 old_child, u32 new_child) {
+		if (parent == NULL_NODE) {
+			tree->root = new_child;
+			return;
+		}
+		Node& p = tree->nodes.data[parent];
+		if (p.child[0] == old_child) p.child[0] = new_child;
+		else p.child[1] = new_child;
+	}
+
+	// Rotates the taller grandchild up when a's children differ in height by more than one.
+	// Returns the index now at a's position.
+	inline u32 balance(Tree* tree, u32 ia) {
+		Node* n = tree->nodes.data;
+		if (is_leaf(n[ia]) || n[ia].height < 2) return ia;
+
+		u32 ib = n[ia].child[0];
+		u32 ic = n[ia].child[1];
+		i32 diff = n[ic].height - n[ib].height;
+		if (diff >= -1 && diff <= 1) return ia;
+
+		// `up` replaces a; its shorter child moves under a in place of `up`
+		u32 up = diff > 1 ? ic : ib;
+		u32 keep = diff > 1 ? ib : ic;
+		u32 slot = diff > 1 ? 1 : 0;
+		u32 f = n[up].child[0];
+		u32 g = n[up].child[1];
+		u32 tall = n[f].height > n[g].height ? f : g;
+		u32 shorter = tall == f ? g : f;
+
+		n[up].parent = n[ia].parent;
+		replace_child(tree, n[up].parent, ia, up);
+		n[up].child[0] = ia;
+		n[up].child[1] = tall;
+		n[ia].parent = up;
+
+		n[ia].child[slot] = shorter;
+		n[ia].child[slot ^ 1] = keep;
+		n[shorter].parent = ia;
+
+		n[ia].box = box_union(n[keep].box, n[shorter].box);
+		n[ia].height = 1 + (n[keep].height > n[shorter].height ? n[keep].height : n[shorter].height);
+		n[up].box = box_union(n[ia].box, n[tall].box);
+		n[up].height = 1 + (n[ia].height > n[tall].height ? n[ia].height : n[tall].height);
+		return up;
+	}
+
+	// Refits and rebalances from i to the root.
+	inline void fix_upwards(Tree* tree, u32 i) {
+		while (i != NULL_NODE) {
+			i = balance(tree, i);
+			Node* n = tree->nodes.data;
+			u32 c0 = n[i].child[0];
+			u32 c1 = n[i].child[1];
+			n[i].height = 1 + (n[c0].height > n[c1].height ? n[c0].height : n[c1].height);
+			n[i].box = box_union(n[c0].box, n[c1].box);
+			i = n[i].parent;
+		}
+	}
+
+	inline void insert_leaf(Tree* tree, u32 leaf) {
+		if (tree->root == NULL_NODE) {
+			tree->root = leaf;
+			tree->nodes.data[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		// Descend towards the sibling with the lowest added surface area
+		AABB box = tree->nodes.data[leaf].box;
+		u32 index = tree->root;
+		while (!is_leaf(tree->nodes.data[index])) {
+			const Node* n = tree->nodes.data;
+			f32 area = box_cost(n[index].box);
+			f32 combined = box_cost(box_union(n[index].box, box));
+			f32 cost = 2.0f * combined;
+			f32 inheritance = 2.0f * (combined - area);
+
+			f32 child_cost[2];
+			for (u32 c = 0; c < 2; c++) {
+				const Node& child = n[n[index].child[c]];
+				f32 grown = box_cost(box_union(box, child.box));
+				child_cost[c] = (is_leaf(child) ? grown : grown - box_cost(child.box)) + inheritance;
+			}
+
+			if (cost < child_cost[0] && cost < child_cost[1]) break;
+			index = n[index].child[child_cost[0] < child_cost[1] ? 0 : 1];
+		}
+
+		u32 sibling = index;
+		u32 new_parent = alloc_node(tree);
+		Node* n = tree->nodes.data;
+		u32 old_parent = n[sibling].parent;
+		n[new_parent].parent = old_parent;
+		n[new_parent].box = box_union(box, n[sibling].box);
+		n[new_parent].height = n[sibling].height + 1;
+		n[new_parent].child[0] = sibling;
+		n[new_parent].child[1] = leaf;
+		replace_child(tree, old_parent, sibling, new_parent);
+		n[sibling].parent = new_parent;
+		n[leaf].parent = new_parent;
+
+		fix_upwards(tree, new_parent);
+	}
+
+	inline void remove_leaf(Tree* tree, u32 leaf) {
+		if (leaf == tree->root) {
+			tree->root = NULL_NODE;
+			return;
+		}
+
+		Node* n = tree->nodes.data;
+		u32 parent = n[leaf].parent;
+		u32 grand = n[parent].parent;
+		u32 sibling = n[parent].child[0] == leaf ? n[parent].child[1] : n[parent].child[0];
+
+		replace_child(tree, grand, parent, sibling);
+		n[sibling].parent = grand;
+		free_node(tree, parent);
+		fix_upwards(tree, grand);
+	}
+
+	// Returns the proxy that identifies the leaf in remove/move.
+	inline u32 insert(Tree* tree, const AABB& box, u32 user) {
+		u32 leaf = alloc_node(tree);
+		vec3 m = { tree->margin, tree->margin, tree->margin };
+		Node& n = tree->nodes.data[leaf];
+		n.box = { box.min - m, box.max + m };
+		n.user = user;
+		insert_leaf(tree, leaf);
+		tree->leaf_count++;
+		return leaf;
+	}
+
+	inline void remove(Tree* tree, u32 proxy) {
+		remove_leaf(tree, proxy);
+		free_node(tree, proxy);
+		tree->leaf_count--;
+	}
+
+	// Reinserts the leaf only when box has left its fat box. Returns true if the tree changed.
+	inline bool move(Tree* tree, u32 proxy, const AABB& box) {
+		if (box_contains(tree->nodes.data[proxy].box, box)) return false;
+		remove_leaf(tree, proxy);
+		vec3 m = { tree->margin, tree->margin, tree->margin };
+		tree->nodes.data[proxy].box = { box.min - m, box.max + m };
+		insert_leaf(tree, proxy);
+		return true;
+	}
+
+	// Calls fn(user) for every leaf whose fat box overlaps box.
+	template<typename Fn>
+	void query_aabb(const Tree* tree, const AABB& box, Fn fn) {
+		if (tree->leaf_count == 0) return;
+		u32 stack[MAX_STACK];
+		u32 top = 0;
+		stack[top++] = tree->root;
+		while (top > 0) {
+			const Node& n = tree->nodes.data[stack[--top]];
+			if (!box_overlaps(n.box, box)) continue;
+			if (is_leaf(n)) {
+				fn(n.user);
+			} else if (top + 2 <= MAX_STACK) {
+				stack[top++] = n.child[0];
+				stack[top++] = n.child[1];
+			}
+		}
+	}
+
+	// Calls fn(user, inside) for every leaf whose fat box is not outside f. inside is true when the
+	// fat box, and so the leaf's real box, is entirely within the frustum; otherwise the caller
+	// still has to test the real box.
+	template<typename Fn>
+	void query_frustum(const Tree* tree, const Frustum& f, Fn fn) {
+		if (tree->leaf_count == 0) return;
+		struct Entry { u32 node; u32 planes; };
+		Entry stack[MAX_STACK];
+		u32 top = 0;
+		stack[top++] = { tree->root, 0x3F };
+		while (top > 0) {
+			Entry e = stack[--top];
+			const Node& n = tree->nodes.data[e.node];
+
+			u32 planes = e.planes;
+			if (planes) {
+				vec3 c = (n.box.min + n.box.max) * 0.5f;
+				vec3 h = (n.box.max - n.box.min) * 0.5f;
+				bool outside = false;
+				for (u32 p = 0; p < 6 && !outside; p++) {
+					if (!(planes & (1u << p))) continue;
+					const vec4& pl = f.planes[p];
+					f32 d = pl.x * c.x + pl.y * c.y + pl.z * c.z + pl.w;
+					f32 r = fabsf(pl.x) * h.x + fabsf(pl.y) * h.y + fabsf(pl.z) * h.z;
+					if (d + r < 0.0f) outside = true;
+					else if (d - r >= 0.0f) planes &= ~(1u << p);
+				}
+				if (outside) continue;
+			}
+
+			if (is_leaf(n)) {
+				fn(n.user, planes == 0);
+			} else if (top + 2 <= MAX_STACK) {
+				stack[top++] = { n.child[0], planes };
+				stack[top++] = { n.child[1], planes };
+			}
+		}
+	}
+
+	// Visits leaves whose fat box the ray origin + t * dir enters within [0, max_t], roughly
+	// nearest first. fn(user, max_t) returns the distance to clip the ray to: its hit distance, or
+	// max_t unchanged for a miss.
+	template<typename Fn>
+	void raycast(const Tree* tree, vec3 origin, vec3 dir, f32 max_t, Fn fn) {
+		if (tree->leaf_count == 0) return;
+		vec3 inv_dir = { 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z };
+		u32 stack[MAX_STACK];
+		u32 top = 0;
+		stack[top++] = tree->root;
+		while (top > 0) {
+			const Node& n = tree->nodes.data[stack[--top]];
+			if (ray_intersect_aabb(origin, inv_dir, n.box, max_t) < 0.0f) continue;
+			if (is_leaf(n)) {
+				max_t = fn(n.user, max_t);
+				continue;
+			}
+			if (top + 2 > MAX_STACK) continue;
+
+			// Push the farther child first so the nearer one is visited first and clips sooner
+			const Node& a = tree->nodes.data[n.child[0]];
+			const Node& b = tree->nodes.data[n.child[1]];
+			vec3 ca = (a.box.min + a.box.max) * 0.5f - origin;
+			vec3 cb = (b.box.min + b.box.max) * 0.5f - origin;
+			bool a_first = dot(ca, dir) < dot(cb, dir);
+			stack[top++] = a_first ? n.child[1] : n.child[0];
+			stack[top++] = a_first ? n.child[0] : n.child[1];
+		}
+	}
+
+}
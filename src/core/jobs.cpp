@@ -0,0 +1,174 @@
+#include "jobs.hpp"
+#include "log.hpp"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+namespace jobs {
+
+	namespace {
+
+		struct Job {
+			JobFn  fn;
+			void*  user;
+			u32    begin;
+			u32    end;
+			Group* group;
+		};
+
+		struct Queue {
+			Job* jobs;
+			u32  size;
+			u32  head;
+			u32  tail;
+		};
+
+		constexpr u32 MAX_WORKERS = MAX_THREADS - 1;
+		constexpr u32 QUEUE_SIZE = 4096;
+		constexpr u32 BACKGROUND_QUEUE_SIZE = 64;
+
+		Job     main_jobs[QUEUE_SIZE];
+		Job     background_jobs[BACKGROUND_QUEUE_SIZE];
+		Queue   main_queue = { main_jobs, QUEUE_SIZE, 0, 0 };
+		Queue   background_queue = { background_jobs, BACKGROUND_QUEUE_SIZE, 0, 0 }; // only idle workers take these
+		SRWLOCK queue_lock = SRWLOCK_INIT;
+		HANDLE  work_semaphore = nullptr;
+		HANDLE  threads[MAX_WORKERS];
+		u32     thread_count = 0;
+		volatile LONG quitting = 0;
+		thread_local u32 local_thread_index = 0;
+
+	}
+
+	static bool pop(Queue* queue, Job* out) {
+		AcquireSRWLockExclusive(&queue_lock);
+		bool found = queue->head != queue->tail;
+		if (found) {
+			*out = queue->jobs[queue->head % queue->size];
+			queue->head++;
+		}
+		ReleaseSRWLockExclusive(&queue_lock);
+		return found;
+	}
+
+	static bool push(Queue* queue, const Job& job) {
+		AcquireSRWLockExclusive(&queue_lock);
+		bool full = queue->tail - queue->head >= queue->size;
+		if (!full) {
+			queue->jobs[queue->tail % queue->size] = job;
+			queue->tail++;
+		}
+		ReleaseSRWLockExclusive(&queue_lock);
+		return !full;
+	}
+
+	static void execute(const Job& job) {
+		job.fn(job.user, job.begin, job.end);
+		InterlockedDecrement(&job.group->pending);
+	}
+
+	static DWORD WINAPI worker_main(LPVOID param) {
+		local_thread_index = (u32)(usize)param;
+		for (;;) {
+			WaitForSingleObject(work_semaphore, INFINITE);
+			if (quitting) break;
+			Job job;
+			if (pop(&main_queue, &job) || pop(&background_queue, &job)) execute(job);
+		}
+		return 0;
+	}
+
+	void init(u32 count) {
+		if (count == 0) {
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			count = info.dwNumberOfProcessors > 1 ? (u32)info.dwNumberOfProcessors - 1 : 0;
+		}
+		if (count > MAX_WORKERS) count = MAX_WORKERS;
+
+		quitting = 0;
+		work_semaphore = CreateSemaphoreA(nullptr, 0, 0x7FFFFFFF, nullptr);
+		for (u32 i = 0; i < count; i++) {
+			threads[thread_count] = CreateThread(nullptr, 0, worker_main, (LPVOID)(usize)(thread_count + 1), 0, nullptr);
+			if (threads[thread_count]) thread_count++;
+		}
+
+		logger::info("jobs: started %u workers", thread_count);
+	}
+
+	void shutdown() {
+		InterlockedExchange(&quitting, 1);
+		if (thread_count > 0) {
+			ReleaseSemaphore(work_semaphore, (LONG)thread_count, nullptr);
+			WaitForMultipleObjects(thread_count, threads, TRUE, INFINITE);
+			for (u32 i = 0; i < thread_count; i++) CloseHandle(threads[i]);
+		}
+		if (work_semaphore) CloseHandle(work_semaphore);
+		work_semaphore = nullptr;
+		thread_count = 0;
+		main_queue.head = main_queue.tail = 0;
+		background_queue.head = background_queue.tail = 0;
+	}
+
+	u32 worker_count() { return thread_count; }
+
+	u32 thread_index() { return local_thread_index; }
+
+	static void submit_to(Queue* queue, Group* group, JobFn fn, void* user, u32 begin, u32 end) {
+		InterlockedIncrement(&group->pending);
+		Job job = { fn, user, begin, end, group };
+
+		if (thread_count == 0 || !push(queue, job)) {
+			execute(job);
+			return;
+		}
+		ReleaseSemaphore(work_semaphore, 1, nullptr);
+	}
+
+	void submit(Group* group, JobFn fn, void* user, u32 begin, u32 end) {
+		submit_to(&main_queue, group, fn, user, begin, end);
+	}
+
+	void submit_background(Group* group, JobFn fn, void* user) {
+		submit_to(&background_queue, group, fn, user, 0, 1);
+	}
+
+	void wait(Group* group) {
+		while (group->pending > 0) {
+			Job job;
+			if (pop(&main_queue, &job)) {
+				execute(job);
+			} else {
+				YieldProcessor();
+			}
+		}
+	}
+
+	bool done(const Group* group) {
+		return group->pending == 0;
+	}
+
+	void parallel_for(u32 count, u32 min_batch, JobFn fn, void* user) {
+		if (count == 0) return;
+
+		// A few ranges per thread so uneven ranges still balance out
+		u32 target = (thread_count + 1) * 4;
+		u32 batch = (count + target - 1) / target;
+		if (batch < min_batch) batch = min_batch;
+		if (batch == 0) batch = 1;
+
+		if (thread_count == 0 || batch >= count) {
+			fn(user, 0, count);
+			return;
+		}
+
+		Group group = {};
+		for (u32 begin = 0; begin < count; begin += batch) {
+			u32 end = begin + batch < count ? begin + batch : count;
+			submit(&group, fn, user, begin, end);
+		}
+		wait(&group);
+	}
+
+}
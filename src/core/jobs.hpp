@@ -0,0 +1,31 @@
+#pragma once
+
+#include "types.hpp"
+
+namespace jobs {
+
+	using JobFn = void (*)(void* user, u32 begin, u32 end);
+
+	// Jobs submitted to a group are tracked by its pending count; wait() blocks until it drains.
+	struct Group {
+		volatile long pending;
+	};
+
+	constexpr u32 MAX_THREADS = 64; // workers plus the main thread
+
+	void init(u32 worker_count = 0); // 0 = one worker per core, minus the main thread
+	void shutdown();
+	u32  worker_count();
+	u32  thread_index(); // 0 on the main thread, 1..worker_count() on workers
+
+	void submit(Group* group, JobFn fn, void* user, u32 begin, u32 end);
+	// For long jobs (loading files) that must not stall a frame: they go on a separate queue that
+	// only idle workers take from and wait() never runs. Inline when there are no workers.
+	void submit_background(Group* group, JobFn fn, void* user);
+	void wait(Group* group); // the caller runs queued jobs while it waits, background ones excepted
+	bool done(const Group* group); // polls without blocking or running jobs
+
+	// Splits [0, count) into ranges of at least min_batch, runs them across workers and the caller, and blocks until done.
+	void parallel_for(u32 count, u32 min_batch, JobFn fn, void* user);
+
+}
@@ -3,12 +3,27 @@
 #include "types.hpp"
 #include <math.h>
 
+// mat4 products, point transforms and box transforms run once or more per entity per frame, so they
+// use SSE when the target has it, one column per register. Selection is at compile time (an AVX
+// build gets the same kernels VEX-encoded); define MATH_NO_SIMD to force the scalar code.
+// Each SIMD kernel does the same multiplies and adds in the same order as its *_scalar reference,
+// so results are bit-identical as long as the compiler is not allowed to contract them into FMAs.
+#if !defined(MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATH_SSE 1
+#include <emmintrin.h>
+#endif
+
 struct vec2 { f32 x, y; };
 struct vec3 { f32 x, y, z; };
 struct vec4 { f32 x, y, z, w; };
 
+struct quat { f32 x, y, z, w; };
 struct mat4 { f32 col[4][4]; };
 
+// Affine transform with the constant (0, 0, 0, 1) row dropped: three rows of (linear | translation).
+// 48 bytes instead of 64, and it is also the std430 layout of a GLSL mat3x4 used as `vec4(p, 1) * m`.
+struct mat3x4 { f32 row[3][4]; };
+
 inline vec2 operator+(vec2 a, vec2 b) { return { a.x + b.x, a.y + b.y }; }
 inline vec2 operator-(vec2 a, vec2 b) { return { a.x - b.x, a.y - b.y }; }
 inline vec2 operator*(vec2 v, f32 s) { return { v.x * s,   v.y * s }; }
@@ -44,6 +59,58 @@ inline vec4 operator+(vec4 a, vec4 b) { return { a.x + b.x, a.y + b.y, a.z + b.z
 inline vec4 operator*(vec4 v, f32 s) { return { v.x * s, v.y * s, v.z * s, v.w * s }; }
 inline f32  dot(vec4 a, vec4 b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
 
+inline quat quat_identity() { return { 0.0f, 0.0f, 0.0f, 1.0f }; }
+
+inline quat operator*(quat a, quat b) {
+    return {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+}
+
+inline quat quat_normalize(quat q) {
+    f32 len = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (len <= 0.0f) return quat_identity();
+    f32 inv = 1.0f / len;
+    return { q.x * inv, q.y * inv, q.z * inv, q.w * inv };
+}
+
+inline quat quat_axis_angle(vec3 axis, f32 angle) {
+    f32 s = sinf(angle * 0.5f);
+    return { axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f) };
+}
+
+// Euler angles as the editor and scene files use them: yaw about Y, then pitch about X, then roll
+// about Z, i.e. R = Ry(yaw) * Rx(pitch) * Rz(roll).
+inline quat quat_from_euler(vec3 yaw_pitch_roll) {
+    f32 cy = cosf(yaw_pitch_roll.x * 0.5f), sy = sinf(yaw_pitch_roll.x * 0.5f);
+    f32 cp = cosf(yaw_pitch_roll.y * 0.5f), sp = sinf(yaw_pitch_roll.y * 0.5f);
+    f32 cr = cosf(yaw_pitch_roll.z * 0.5f), sr = sinf(yaw_pitch_roll.z * 0.5f);
+    return {
+        cy * sp * cr + sy * cp * sr,
+        sy * cp * cr - cy * sp * sr,
+        cy * cp * sr - sy * sp * cr,
+        cy * cp * cr + sy * sp * sr
+    };
+}
+
+// Inverse of quat_from_euler. At pitch +-90 degrees roll is folded into yaw.
+inline vec3 quat_to_euler(quat q) {
+    f32 m02 = 2.0f * (q.x * q.z + q.w * q.y);
+    f32 m12 = 2.0f * (q.y * q.z - q.w * q.x);
+    f32 m22 = 1.0f - 2.0f * (q.x * q.x + q.y * q.y);
+    f32 m10 = 2.0f * (q.x * q.y + q.w * q.z);
+    f32 m11 = 1.0f - 2.0f * (q.x * q.x + q.z * q.z);
+    if (m12 > 0.99999f || m12 < -0.99999f) {
+        f32 m00 = 1.0f - 2.0f * (q.y * q.y + q.z * q.z);
+        f32 m20 = 2.0f * (q.x * q.z - q.w * q.y);
+        return { atan2f(-m20, m00), m12 > 0.0f ? -1.57079632679f : 1.57079632679f, 0.0f };
+    }
+    return { atan2f(m02, m22), asinf(-m12), atan2f(m10, m11) };
+}
+
 inline mat4 mat4_identity() {
     mat4 m = {};
     m.col[0][0] = 1.0f;
@@ -53,7 +120,7 @@ inline mat4 mat4_identity() {
     return m;
 }
 
-inline mat4 mat4_mul(mat4 a, mat4 b) {
+inline mat4 mat4_mul_scalar(mat4 a, mat4 b) {
     mat4 r = {};
     for (int c = 0; c < 4; c++) {
         for (int row = 0; row < 4; row++) {
@@ -67,6 +134,27 @@ inline mat4 mat4_mul(mat4 a, mat4 b) {
     return r;
 }
 
+inline mat4 mat4_mul(mat4 a, mat4 b) {
+#if MATH_SSE
+    __m128 a0 = _mm_loadu_ps(a.col[0]);
+    __m128 a1 = _mm_loadu_ps(a.col[1]);
+    __m128 a2 = _mm_loadu_ps(a.col[2]);
+    __m128 a3 = _mm_loadu_ps(a.col[3]);
+    mat4 r;
+    for (int c = 0; c < 4; c++) {
+        __m128 bc = _mm_loadu_ps(b.col[c]);
+        __m128 v = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00));
+        v = _mm_add_ps(v, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55)));
+        v = _mm_add_ps(v, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xAA)));
+        v = _mm_add_ps(v, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xFF)));
+        _mm_storeu_ps(r.col[c], v);
+    }
+    return r;
+#else
+    return mat4_mul_scalar(a, b);
+#endif
+}
+
 inline mat4 operator*(mat4 a, mat4 b) { return mat4_mul(a, b); }
 
 inline mat4 mat4_translate(vec3 t) {
@@ -135,7 +223,37 @@ inline mat4 mat4_perspective(f32 fov_y, f32 aspect, f32 z_near, f32 z_far) {
     return m;
 }
 
-inline vec3 mat4_transform_point(mat4 m, vec3 p) {
+// translate * rotate * scale written straight into the matrix: no sin/cos and no 4x4 products.
+// r must be normalized.
+inline mat4 mat4_from_trs(vec3 t, quat r, vec3 s) {
+    f32 xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+    f32 xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+    f32 wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+    mat4 m;
+    m.col[0][0] = (1.0f - 2.0f * (yy + zz)) * s.x;
+    m.col[0][1] = 2.0f * (xy + wz) * s.x;
+    m.col[0][2] = 2.0f * (xz - wy) * s.x;
+    m.col[0][3] = 0.0f;
+
+    m.col[1][0] = 2.0f * (xy - wz) * s.y;
+    m.col[1][1] = (1.0f - 2.0f * (xx + zz)) * s.y;
+    m.col[1][2] = 2.0f * (yz + wx) * s.y;
+    m.col[1][3] = 0.0f;
+
+    m.col[2][0] = 2.0f * (xz + wy) * s.z;
+    m.col[2][1] = 2.0f * (yz - wx) * s.z;
+    m.col[2][2] = (1.0f - 2.0f * (xx + yy)) * s.z;
+    m.col[2][3] = 0.0f;
+
+    m.col[3][0] = t.x;
+    m.col[3][1] = t.y;
+    m.col[3][2] = t.z;
+    m.col[3][3] = 1.0f;
+    return m;
+}
+
+inline vec3 mat4_transform_point_scalar(mat4 m, vec3 p) {
     return {
         m.col[0][0]*p.x + m.col[1][0]*p.y + m.col[2][0]*p.z + m.col[3][0],
         m.col[0][1]*p.x + m.col[1][1]*p.y + m.col[2][1]*p.z + m.col[3][1],
@@ -143,7 +261,7 @@ inline vec3 mat4_transform_point(mat4 m, vec3 p) {
     };
 }
 
-inline vec3 mat4_transform_dir(mat4 m, vec3 d) {
+inline vec3 mat4_transform_dir_scalar(mat4 m, vec3 d) {
     return {
         m.col[0][0]*d.x + m.col[1][0]*d.y + m.col[2][0]*d.z,
         m.col[0][1]*d.x + m.col[1][1]*d.y + m.col[2][1]*d.z,
@@ -151,6 +269,40 @@ inline vec3 mat4_transform_dir(mat4 m, vec3 d) {
     };
 }
 
+#if MATH_SSE
+inline __m128 mat4_transform_dir_sse(const mat4& m, vec3 d) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(m.col[0]), _mm_set1_ps(d.x));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(m.col[1]), _mm_set1_ps(d.y)));
+    return _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(m.col[2]), _mm_set1_ps(d.z)));
+}
+
+inline __m128 mat4_transform_point_sse(const mat4& m, vec3 p) {
+    return _mm_add_ps(mat4_transform_dir_sse(m, p), _mm_loadu_ps(m.col[3]));
+}
+
+inline vec3 vec3_from_sse(__m128 v) {
+    f32 out[4];
+    _mm_storeu_ps(out, v);
+    return { out[0], out[1], out[2] };
+}
+#endif
+
+inline vec3 mat4_transform_point(mat4 m, vec3 p) {
+#if MATH_SSE
+    return vec3_from_sse(mat4_transform_point_sse(m, p));
+#else
+    return mat4_transform_point_scalar(m, p);
+#endif
+}
+
+inline vec3 mat4_transform_dir(mat4 m, vec3 d) {
+#if MATH_SSE
+    return vec3_from_sse(mat4_transform_dir_sse(m, d));
+#else
+    return mat4_transform_dir_scalar(m, d);
+#endif
+}
+
 constexpr f32 PI = 3.14159265358979323846f;
 constexpr f32 TAU = 6.28318530717958647692f;
 
@@ -162,7 +314,7 @@ struct AABB {
     vec3 max;
 };
 
-inline AABB aabb_transform(const AABB& local, mat4 m) {
+inline AABB aabb_transform_scalar(const AABB& local, mat4 m) {
     vec3 center = (local.min + local.max) * 0.5f;
     vec3 extent = (local.max - local.min) * 0.5f;
     vec3 new_center = mat4_transform_point(m, center);
@@ -175,11 +327,334 @@ inline AABB aabb_transform(const AABB& local, mat4 m) {
     return { new_center - new_extent, new_center + new_extent };
 }
 
+#if MATH_SSE
+inline void aabb_transform_sse(const AABB& local, const mat4& m, __m128* new_center, __m128* new_extent) {
+    vec3 center = (local.min + local.max) * 0.5f;
+    vec3 extent = (local.max - local.min) * 0.5f;
+    *new_center = mat4_transform_point_sse(m, center);
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 e = _mm_mul_ps(_mm_and_ps(_mm_loadu_ps(m.col[0]), abs_mask), _mm_set1_ps(extent.x));
+    e = _mm_add_ps(e, _mm_mul_ps(_mm_and_ps(_mm_loadu_ps(m.col[1]), abs_mask), _mm_set1_ps(extent.y)));
+    *new_extent = _mm_add_ps(e, _mm_mul_ps(_mm_and_ps(_mm_loadu_ps(m.col[2]), abs_mask), _mm_set1_ps(extent.z)));
+}
+#endif
+
+inline AABB aabb_transform(const AABB& local, mat4 m) {
+#if MATH_SSE
+    __m128 center, extent;
+    aabb_transform_sse(local, m, &center, &extent);
+    return { vec3_from_sse(_mm_sub_ps(center, extent)), vec3_from_sse(_mm_add_ps(center, extent)) };
+#else
+    return aabb_transform_scalar(local, m);
+#endif
+}
+
+// Same box as aabb_transform, as world-space center and half extent.
+inline void aabb_transform_center_extent(const AABB& local, const mat4& m, vec3* center, vec3* extent) {
+#if MATH_SSE
+    __m128 c, e;
+    aabb_transform_sse(local, m, &c, &e);
+    *center = vec3_from_sse(c);
+    *extent = vec3_from_sse(e);
+#else
+    *center = mat4_transform_point_scalar(m, (local.min + local.max) * 0.5f);
+    vec3 half = (local.max - local.min) * 0.5f;
+    *extent = {
+        fabsf(m.col[0][0]) * half.x + fabsf(m.col[1][0]) * half.y + fabsf(m.col[2][0]) * half.z,
+        fabsf(m.col[0][1]) * half.x + fabsf(m.col[1][1]) * half.y + fabsf(m.col[2][1]) * half.z,
+        fabsf(m.col[0][2]) * half.x + fabsf(m.col[1][2]) * half.y + fabsf(m.col[2][2]) * half.z
+    };
+#endif
+}
+
+inline mat3x4 mat3x4_identity() {
+    mat3x4 m = {};
+    m.row[0][0] = 1.0f;
+    m.row[1][1] = 1.0f;
+    m.row[2][2] = 1.0f;
+    return m;
+}
+
+// Same matrix as mat4_from_trs without the last row. r must be normalized.
+inline mat3x4 mat3x4_from_trs(vec3 t, quat r, vec3 s) {
+    f32 xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+    f32 xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+    f32 wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+    mat3x4 m;
+    m.row[0][0] = (1.0f - 2.0f * (yy + zz)) * s.x;
+    m.row[0][1] = 2.0f * (xy - wz) * s.y;
+    m.row[0][2] = 2.0f * (xz + wy) * s.z;
+    m.row[0][3] = t.x;
+
+    m.row[1][0] = 2.0f * (xy + wz) * s.x;
+    m.row[1][1] = (1.0f - 2.0f * (xx + zz)) * s.y;
+    m.row[1][2] = 2.0f * (yz - wx) * s.z;
+    m.row[1][3] = t.y;
+
+    m.row[2][0] = 2.0f * (xz - wy) * s.x;
+    m.row[2][1] = 2.0f * (yz + wx) * s.y;
+    m.row[2][2] = (1.0f - 2.0f * (xx + yy)) * s.z;
+    m.row[2][3] = t.z;
+    return m;
+}
+
+constexpr u32 TRS_BLOCK = 64;
+
+// Translations, rotations and scales of up to TRS_BLOCK entities as 64-byte aligned columns.
+struct alignas(64) TrsBlock {
+    f32 t[3][TRS_BLOCK];
+    f32 r[4][TRS_BLOCK];
+    f32 s[3][TRS_BLOCK];
+};
+
+#if MATH_SSE
+// Four lanes of mat3x4_from_trs starting at i, in the same operation order. Each row is built as a
+// column of four entities and transposed into out[0..3].
+inline void mat3x4_from_trs_sse(const TrsBlock* b, u32 i, mat3x4* const* out) {
+    __m128 rx = _mm_load_ps(b->r[0] + i), ry = _mm_load_ps(b->r[1] + i);
+    __m128 rz = _mm_load_ps(b->r[2] + i), rw = _mm_load_ps(b->r[3] + i);
+    __m128 sx = _mm_load_ps(b->s[0] + i), sy = _mm_load_ps(b->s[1] + i), sz = _mm_load_ps(b->s[2] + i);
+    __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+
+    __m128 xx = _mm_mul_ps(rx, rx), yy = _mm_mul_ps(ry, ry), zz = _mm_mul_ps(rz, rz);
+    __m128 xy = _mm_mul_ps(rx, ry), xz = _mm_mul_ps(rx, rz), yz = _mm_mul_ps(ry, rz);
+    __m128 wx = _mm_mul_ps(rw, rx), wy = _mm_mul_ps(rw, ry), wz = _mm_mul_ps(rw, rz);
+
+    __m128 m0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+    __m128 m1 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+    __m128 m2 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+    __m128 m3 = _mm_load_ps(b->t[0] + i);
+    _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+    _mm_storeu_ps(out[0]->row[0], m0); _mm_storeu_ps(out[1]->row[0], m1);
+    _mm_storeu_ps(out[2]->row[0], m2); _mm_storeu_ps(out[3]->row[0], m3);
+
+    m0 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+    m1 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+    m2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+    m3 = _mm_load_ps(b->t[1] + i);
+    _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+    _mm_storeu_ps(out[0]->row[1], m0); _mm_storeu_ps(out[1]->row[1], m1);
+    _mm_storeu_ps(out[2]->row[1], m2); _mm_storeu_ps(out[3]->row[1], m3);
+
+    m0 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+    m1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+    m2 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+    m3 = _mm_load_ps(b->t[2] + i);
+    _MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+    _mm_storeu_ps(out[0]->row[2], m0); _mm_storeu_ps(out[1]->row[2], m1);
+    _mm_storeu_ps(out[2]->row[2], m2); _mm_storeu_ps(out[3]->row[2], m3);
+}
+#endif
+
+// *out[i] = mat3x4_from_trs for the first count entities of b, 8 per step, with identical results.
+inline void mat3x4_from_trs_block(const TrsBlock* b, u32 count, mat3x4* const* out) {
+    u32 i = 0;
+#if MATH_SSE
+    for (; i + 8 <= count; i += 8) {
+        mat3x4_from_trs_sse(b, i, out + i);
+        mat3x4_from_trs_sse(b, i + 4, out + i + 4);
+    }
+#endif
+    for (; i < count; i++) {
+        *out[i] = mat3x4_from_trs({ b->t[0][i], b->t[1][i], b->t[2][i] },
+                                  { b->r[0][i], b->r[1][i], b->r[2][i], b->r[3][i] },
+                                  { b->s[0][i], b->s[1][i], b->s[2][i] });
+    }
+}
+
+inline mat4 mat4_from_mat3x4(const mat3x4& a) {
+    mat4 m;
+    for (int c = 0; c < 4; c++) {
+        m.col[c][0] = a.row[0][c];
+        m.col[c][1] = a.row[1][c];
+        m.col[c][2] = a.row[2][c];
+        m.col[c][3] = c == 3 ? 1.0f : 0.0f;
+    }
+    return m;
+}
+
+// a * b with the implicit last rows: 36 multiplies instead of 64.
+inline mat3x4 mat3x4_mul_scalar(const mat3x4& a, const mat3x4& b) {
+    mat3x4 r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            r.row[i][j] = a.row[i][0] * b.row[0][j] + a.row[i][1] * b.row[1][j] + a.row[i][2] * b.row[2][j];
+        }
+        r.row[i][3] += a.row[i][3];
+    }
+    return r;
+}
+
+inline mat3x4 mat3x4_mul(const mat3x4& a, const mat3x4& b) {
+#if MATH_SSE
+    mat3x4 r;
+    __m128 b0 = _mm_loadu_ps(b.row[0]);
+    __m128 b1 = _mm_loadu_ps(b.row[1]);
+    __m128 b2 = _mm_loadu_ps(b.row[2]);
+    __m128 w = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 3; i++) {
+        __m128 v = _mm_mul_ps(_mm_set1_ps(a.row[i][0]), b0);
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.row[i][1]), b1));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.row[i][2]), b2));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(a.row[i][3]), w));
+        _mm_storeu_ps(r.row[i], v);
+    }
+    return r;
+#else
+    return mat3x4_mul_scalar(a, b);
+#endif
+}
+
+inline mat3x4 operator*(const mat3x4& a, const mat3x4& b) { return mat3x4_mul(a, b); }
+
+// Inverse of the 3x3 part by cofactors, translation as -inverse * t. Singular input gives identity.
+inline mat3x4 mat3x4_inverse(const mat3x4& m) {
+    const f32 (*a)[4] = m.row;
+    f32 c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+    f32 c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+    f32 c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+    f32 det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+    if (fabsf(det) < 1e-12f) return mat3x4_identity();
+    f32 inv = 1.0f / det;
+
+    mat3x4 r;
+    r.row[0][0] = c00 * inv;
+    r.row[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv;
+    r.row[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv;
+    r.row[1][0] = c01 * inv;
+    r.row[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv;
+    r.row[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv;
+    r.row[2][0] = c02 * inv;
+    r.row[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv;
+    r.row[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv;
+    for (int i = 0; i < 3; i++) {
+        r.row[i][3] = -(r.row[i][0] * a[0][3] + r.row[i][1] * a[1][3] + r.row[i][2] * a[2][3]);
+    }
+    return r;
+}
+
+inline vec3 mat3x4_transform_point(const mat3x4& m, vec3 p) {
+    return {
+        m.row[0][0]*p.x + m.row[0][1]*p.y + m.row[0][2]*p.z + m.row[0][3],
+        m.row[1][0]*p.x + m.row[1][1]*p.y + m.row[1][2]*p.z + m.row[1][3],
+        m.row[2][0]*p.x + m.row[2][1]*p.y + m.row[2][2]*p.z + m.row[2][3]
+    };
+}
+
+inline vec3 mat3x4_transform_dir(const mat3x4& m, vec3 d) {
+    return {
+        m.row[0][0]*d.x + m.row[0][1]*d.y + m.row[0][2]*d.z,
+        m.row[1][0]*d.x + m.row[1][1]*d.y + m.row[1][2]*d.z,
+        m.row[2][0]*d.x + m.row[2][1]*d.y + m.row[2][2]*d.z
+    };
+}
+
+inline void aabb_transform_center_extent_scalar(const AABB& local, const mat3x4& m, vec3* center, vec3* extent) {
+    vec3 half = (local.max - local.min) * 0.5f;
+    *center = mat3x4_transform_point(m, (local.min + local.max) * 0.5f);
+    *extent = {
+        fabsf(m.row[0][0]) * half.x + fabsf(m.row[0][1]) * half.y + fabsf(m.row[0][2]) * half.z,
+        fabsf(m.row[1][0]) * half.x + fabsf(m.row[1][1]) * half.y + fabsf(m.row[1][2]) * half.z,
+        fabsf(m.row[2][0]) * half.x + fabsf(m.row[2][1]) * half.y + fabsf(m.row[2][2]) * half.z
+    };
+}
+
+inline AABB aabb_transform_scalar(const AABB& local, const mat3x4& m) {
+    vec3 center, extent;
+    aabb_transform_center_extent_scalar(local, m, &center, &extent);
+    return { center - extent, center + extent };
+}
+
+#if MATH_SSE
+// The snapshot and BVH run this once per entity. The rows are transposed into columns so the
+// kernel matches the mat4 one above: a column per register, same operation order as the scalar code.
+inline void aabb_transform_sse(const AABB& local, const mat3x4& m, __m128* new_center, __m128* new_extent) {
+    vec3 center = (local.min + local.max) * 0.5f;
+    vec3 extent = (local.max - local.min) * 0.5f;
+    __m128 r0 = _mm_loadu_ps(m.row[0]);
+    __m128 r1 = _mm_loadu_ps(m.row[1]);
+    __m128 r2 = _mm_loadu_ps(m.row[2]);
+    __m128 zero = _mm_setzero_ps();
+    __m128 t0 = _mm_unpacklo_ps(r0, r1);   // m00 m10 m01 m11
+    __m128 t1 = _mm_unpacklo_ps(r2, zero); // m20 0   m21 0
+    __m128 t2 = _mm_unpackhi_ps(r0, r1);   // m02 m12 m03 m13
+    __m128 t3 = _mm_unpackhi_ps(r2, zero); // m22 0   m23 0
+    __m128 c0 = _mm_movelh_ps(t0, t1);
+    __m128 c1 = _mm_movehl_ps(t1, t0);
+    __m128 c2 = _mm_movelh_ps(t2, t3);
+    __m128 c3 = _mm_movehl_ps(t3, t2);
+
+    __m128 c = _mm_mul_ps(c0, _mm_set1_ps(center.x));
+    c = _mm_add_ps(c, _mm_mul_ps(c1, _mm_set1_ps(center.y)));
+    c = _mm_add_ps(c, _mm_mul_ps(c2, _mm_set1_ps(center.z)));
+    *new_center = _mm_add_ps(c, c3);
+
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 e = _mm_mul_ps(_mm_and_ps(c0, abs_mask), _mm_set1_ps(extent.x));
+    e = _mm_add_ps(e, _mm_mul_ps(_mm_and_ps(c1, abs_mask), _mm_set1_ps(extent.y)));
+    *new_extent = _mm_add_ps(e, _mm_mul_ps(_mm_and_ps(c2, abs_mask), _mm_set1_ps(extent.z)));
+}
+#endif
+
+inline void aabb_transform_center_extent(const AABB& local, const mat3x4& m, vec3* center, vec3* extent) {
+#if MATH_SSE
+    __m128 c, e;
+    aabb_transform_sse(local, m, &c, &e);
+    *center = vec3_from_sse(c);
+    *extent = vec3_from_sse(e);
+#else
+    aabb_transform_center_extent_scalar(local, m, center, extent);
+#endif
+}
+
+inline AABB aabb_transform(const AABB& local, const mat3x4& m) {
+#if MATH_SSE
+    __m128 center, extent;
+    aabb_transform_sse(local, m, &center, &extent);
+    return { vec3_from_sse(_mm_sub_ps(center, extent)), vec3_from_sse(_mm_add_ps(center, extent)) };
+#else
+    return aabb_transform_scalar(local, m);
+#endif
+}
+
+// Slab test of origin + t * dir against box for t in [0, max_t], with inv_dir = 1 / dir per axis.
+// Returns the entry distance (0 when origin is inside), or -1 on a miss.
+inline f32 ray_intersect_aabb(vec3 origin, vec3 inv_dir, const AABB& box, f32 max_t) {
+    f32 t0 = 0.0f, t1 = max_t;
+    const f32* o = &origin.x;
+    const f32* inv = &inv_dir.x;
+    const f32* lo = &box.min.x;
+    const f32* hi = &box.max.x;
+    for (int a = 0; a < 3; a++) {
+        f32 near_t = (lo[a] - o[a]) * inv[a];
+        f32 far_t = (hi[a] - o[a]) * inv[a];
+        if (near_t > far_t) { f32 tmp = near_t; near_t = far_t; far_t = tmp; }
+        if (near_t > t0) t0 = near_t;
+        if (far_t < t1) t1 = far_t;
+        if (t0 > t1) return -1.0f;
+    }
+    return t0;
+}
+
 struct Frustum {
     vec4 planes[6];
 };
 
-inline Frustum frustum_from_vp(mat4 vp) {
+inline void frustum_normalize(Frustum* f) {
+    for (int i = 0; i < 6; i++) {
+        f32 len = sqrtf(f->planes[i].x*f->planes[i].x + f->planes[i].y*f->planes[i].y + f->planes[i].z*f->planes[i].z);
+        if (len > 0.0001f) {
+            f32 inv = 1.0f / len;
+            f->planes[i].x *= inv;
+            f->planes[i].y *= inv;
+            f->planes[i].z *= inv;
+            f->planes[i].w *= inv;
+        }
+    }
+}
+
+inline Frustum frustum_from_vp_scalar(mat4 vp) {
     Frustum f;
     f.planes[0] = { vp.col[0][3]+vp.col[0][0], vp.col[1][3]+vp.col[1][0], vp.col[2][3]+vp.col[2][0], vp.col[3][3]+vp.col[3][0] };
     f.planes[1] = { vp.col[0][3]-vp.col[0][0], vp.col[1][3]-vp.col[1][0], vp.col[2][3]-vp.col[2][0], vp.col[3][3]-vp.col[3][0] };
@@ -188,19 +663,32 @@ inline Frustum frustum_from_vp(mat4 vp) {
     f.planes[4] = { vp.col[0][3]+vp.col[0][2], vp.col[1][3]+vp.col[1][2], vp.col[2][3]+vp.col[2][2], vp.col[3][3]+vp.col[3][2] };
     f.planes[5] = { vp.col[0][3]-vp.col[0][2], vp.col[1][3]-vp.col[1][2], vp.col[2][3]-vp.col[2][2], vp.col[3][3]-vp.col[3][2] };
 
-    for (int i = 0; i < 6; i++) {
-        f32 len = sqrtf(f.planes[i].x*f.planes[i].x + f.planes[i].y*f.planes[i].y + f.planes[i].z*f.planes[i].z);
-        if (len > 0.0001f) {
-            f32 inv = 1.0f / len;
-            f.planes[i].x *= inv;
-            f.planes[i].y *= inv;
-            f.planes[i].z *= inv;
-            f.planes[i].w *= inv;
-        }
-    }
+    frustum_normalize(&f);
     return f;
 }
 
+// Planes are row 3 plus or minus rows 0..2 of vp; the SSE path transposes once and adds whole rows.
+inline Frustum frustum_from_vp(mat4 vp) {
+#if MATH_SSE
+    __m128 r0 = _mm_loadu_ps(vp.col[0]);
+    __m128 r1 = _mm_loadu_ps(vp.col[1]);
+    __m128 r2 = _mm_loadu_ps(vp.col[2]);
+    __m128 r3 = _mm_loadu_ps(vp.col[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    Frustum f;
+    _mm_storeu_ps(&f.planes[0].x, _mm_add_ps(r3, r0));
+    _mm_storeu_ps(&f.planes[1].x, _mm_sub_ps(r3, r0));
+    _mm_storeu_ps(&f.planes[2].x, _mm_add_ps(r3, r1));
+    _mm_storeu_ps(&f.planes[3].x, _mm_sub_ps(r3, r1));
+    _mm_storeu_ps(&f.planes[4].x, _mm_add_ps(r3, r2));
+    _mm_storeu_ps(&f.planes[5].x, _mm_sub_ps(r3, r2));
+    frustum_normalize(&f);
+    return f;
+#else
+    return frustum_from_vp_scalar(vp);
+#endif
+}
+
 inline bool frustum_test_aabb(const Frustum& f, const AABB& box) {
     for (int i = 0; i < 6; i++) {
         vec3 n = { f.planes[i].x, f.planes[i].y, f.planes[i].z };
@@ -213,3 +701,57 @@ inline bool frustum_test_aabb(const Frustum& f, const AABB& box) {
     }
     return true;
 }
+
+// A box is outside when, for some plane, its center's distance plus its projected radius is negative.
+inline bool frustum_test_center_extent(const Frustum& f, vec3 c, vec3 e) {
+    for (int i = 0; i < 6; i++) {
+        const vec4& p = f.planes[i];
+        f32 d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+        f32 r = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+        if (d + r < 0.0f) return false;
+    }
+    return true;
+}
+
+#if MATH_SSE
+// Four boxes against all six planes; returns the 4-bit inside mask.
+inline u32 frustum_test_boxes_sse(const Frustum& f, __m128 cx, __m128 cy, __m128 cz, __m128 ex, __m128 ey, __m128 ez) {
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int i = 0; i < 6; i++) {
+        __m128 plane = _mm_loadu_ps(&f.planes[i].x);
+        __m128 px = _mm_shuffle_ps(plane, plane, 0x00);
+        __m128 py = _mm_shuffle_ps(plane, plane, 0x55);
+        __m128 pz = _mm_shuffle_ps(plane, plane, 0xAA);
+        __m128 pw = _mm_shuffle_ps(plane, plane, 0xFF);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_mul_ps(pz, cz)), pw);
+        __m128 r = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_and_ps(px, abs_mask), ex),
+            _mm_mul_ps(_mm_and_ps(py, abs_mask), ey)),
+            _mm_mul_ps(_mm_and_ps(pz, abs_mask), ez));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+    }
+    return (u32)_mm_movemask_ps(inside);
+}
+#endif
+
+// Culls up to 64 boxes given as columns of world-space centers and half extents, 8 boxes per step
+// against all six planes. Bit i of the result is set when box i is at least partly inside.
+inline u64 frustum_test_boxes(const Frustum& f, const f32* cx, const f32* cy, const f32* cz,
+                              const f32* ex, const f32* ey, const f32* ez, u32 count) {
+    u64 visible = 0;
+    u32 i = 0;
+#if MATH_SSE
+    for (; i + 8 <= count; i += 8) {
+        u32 lo = frustum_test_boxes_sse(f, _mm_loadu_ps(cx + i), _mm_loadu_ps(cy + i), _mm_loadu_ps(cz + i),
+                                           _mm_loadu_ps(ex + i), _mm_loadu_ps(ey + i), _mm_loadu_ps(ez + i));
+        u32 hi = frustum_test_boxes_sse(f, _mm_loadu_ps(cx + i + 4), _mm_loadu_ps(cy + i + 4), _mm_loadu_ps(cz + i + 4),
+                                           _mm_loadu_ps(ex + i + 4), _mm_loadu_ps(ey + i + 4), _mm_loadu_ps(ez + i + 4));
+        visible |= (u64)(lo | (hi << 4)) << i;
+    }
+#endif
+    for (; i < count; i++) {
+        if (frustum_test_center_extent(f, { cx[i], cy[i], cz[i] }, { ex[i], ey[i], ez[i] })) visible |= 1ull << i;
+    }
+    return visible;
+}
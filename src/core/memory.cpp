@@ -9,14 +9,29 @@ extern "C" void* memset(void*, int, size_t);
 
 extern "C" void* _aligned_malloc(size_t size, size_t alignment);
 extern "C" void _aligned_free(void* ptr);
+extern "C" long long _InterlockedIncrement64(long long volatile* addend);
 
 namespace memory {
 
+	namespace {
+		// Shared by every thread, so work handed to job workers is counted too
+		volatile long long heap_allocations = 0;
+
+		constexpr usize FRAME_ARENA_GRANULE = 64 * 1024;
+
+		// Header in front of a spilled frame allocation; the block is freed with the arena's next frame
+		struct FrameSpill {
+			FrameSpill* next;
+		};
+	}
+
 	void* malloc(usize size) {
+		_InterlockedIncrement64(&heap_allocations);
 		return ::malloc(size);
 	}
 
 	void* realloc(void* block, usize size) {
+		_InterlockedIncrement64(&heap_allocations);
 		return ::realloc(block, size);
 	}
 
@@ -37,6 +52,7 @@ namespace memory {
 	}
 
 	void* mmalloc_aligned(usize size, usize alignment) {
+		_InterlockedIncrement64(&heap_allocations);
 		return ::_aligned_malloc(size, alignment);
 	}
 
@@ -88,4 +104,75 @@ namespace memory {
 		arena->offset = 0;
 	}
 
+	void frame_arena_init(FrameArena* frame, usize size) {
+
+		*frame = {};
+		frame->arenas[0] = arena_create(size);
+		frame->arenas[1] = arena_create(size);
+
+	}
+
+	static void frame_free_spills(FrameArena* frame, u32 index) {
+
+		FrameSpill* spill = (FrameSpill*)frame->spills[index];
+		while (spill) {
+			FrameSpill* next = spill->next;
+			memory::free(spill);
+			spill = next;
+		}
+		frame->spills[index] = nullptr;
+
+	}
+
+	void frame_arena_destroy(FrameArena* frame) {
+
+		for (u32 i = 0; i < 2; i++) {
+			frame_free_spills(frame, i);
+			arena_destroy(&frame->arenas[i]);
+		}
+		*frame = {};
+
+	}
+
+	void frame_begin(FrameArena* frame) {
+
+		frame->current ^= 1;
+		u32 index = frame->current;
+		frame_free_spills(frame, index);
+
+		// Grow to the busiest of the last two frames, so the next frame like it fits without spilling
+		usize need = frame->demand[0] > frame->demand[1] ? frame->demand[0] : frame->demand[1];
+		Arena* arena = &frame->arenas[index];
+		if (need > arena->size) {
+			usize size = (need + need / 4 + FRAME_ARENA_GRANULE - 1) & ~(FRAME_ARENA_GRANULE - 1);
+			arena_destroy(arena);
+			*arena = arena_create(size);
+			frame->grow_count++;
+		}
+
+		arena_reset(arena);
+		frame->demand[index] = 0;
+
+	}
+
+	void* frame_alloc(FrameArena* frame, usize bytes, usize alignment) {
+
+		u32 index = frame->current;
+		frame->demand[index] += bytes + alignment - 1;
+		void* ptr = arena_alloc(&frame->arenas[index], bytes, alignment);
+		if (ptr) return ptr;
+
+		// Out of room this frame: serve from the heap, aligned past the spill header
+		FrameSpill* spill = (FrameSpill*)memory::malloc(sizeof(FrameSpill) + bytes + alignment);
+		spill->next = (FrameSpill*)frame->spills[index];
+		frame->spills[index] = spill;
+		usize address = ((usize)(spill + 1) + alignment - 1) & ~(usize)(alignment - 1);
+		return (void*)address;
+
+	}
+
+	u64 allocation_count() {
+		return (u64)heap_allocations;
+	}
+
 }
@@ -10,6 +10,17 @@ namespace memory {
 		usize offset;
 	};
 
+	// Per-frame scratch: two arenas used on alternate frames, so memory taken in frame N stays valid
+	// through frame N+1. A request that does not fit spills to the heap, and frame_begin grows the
+	// arena to the largest frame seen, so frames of a steady size make no heap allocation.
+	struct FrameArena {
+		Arena arenas[2];
+		void* spills[2]; // heap blocks per arena, freed when that arena is begun again
+		usize demand[2]; // bytes requested from each arena in its last frame, spills included
+		u32   current;
+		u32   grow_count;
+	};
+
 	void* malloc(usize size);
 	void* realloc(void* block, usize size);
 	void free(void* block);
@@ -24,4 +35,23 @@ namespace memory {
 	void* arena_alloc(Arena* arena, usize bytes, usize alignment);
 	void arena_reset(Arena* arena);
 
+	template<typename T>
+	T* arena_push(Arena* arena, usize count) {
+		return (T*)arena_alloc(arena, count * sizeof(T), alignof(T));
+	}
+
+	void frame_arena_init(FrameArena* frame, usize size);
+	void frame_arena_destroy(FrameArena* frame);
+	void frame_begin(FrameArena* frame); // flips to the other arena and resets it
+	void* frame_alloc(FrameArena* frame, usize bytes, usize alignment); // never null
+
+	template<typename T>
+	T* frame_push(FrameArena* frame, usize count) {
+		return (T*)frame_alloc(frame, count * sizeof(T), alignof(T));
+	}
+
+	// Heap allocations (malloc, realloc, aligned) made by all threads so far. Debug aid for code
+	// that must not allocate; compare two readings taken while no other work is running.
+	u64 allocation_count();
+
 }
\ No newline at end of file
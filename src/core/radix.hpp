@@ -0,0 +1,136 @@
+#pragma once
+
+#include "types.hpp"
+#include "memory.hpp"
+#include "jobs.hpp"
+
+namespace radix {
+
+	// Stable LSD radix sort of (key, value) pairs, 8 bits per pass. Passes where every key shares
+	// the same byte are skipped, so small key ranges cost only the passes they actually use.
+	// temp_keys/temp_values must hold count entries; the result is left in keys/values.
+	inline void sort_u64(u64* keys, u32* values, u64* temp_keys, u32* temp_values, u32 count) {
+		if (count < 2) return;
+
+		u64* src_keys = keys;
+		u32* src_values = values;
+		u64* dst_keys = temp_keys;
+		u32* dst_values = temp_values;
+
+		for (u32 shift = 0; shift < 64; shift += 8) {
+			u32 histogram[256] = {};
+			for (u32 i = 0; i < count; i++) histogram[(src_keys[i] >> shift) & 0xFF]++;
+			if (histogram[(src_keys[0] >> shift) & 0xFF] == count) continue;
+
+			u32 running = 0;
+			for (u32 b = 0; b < 256; b++) {
+				u32 n = histogram[b];
+				histogram[b] = running;
+				running += n;
+			}
+			for (u32 i = 0; i < count; i++) {
+				u32 slot = histogram[(src_keys[i] >> shift) & 0xFF]++;
+				dst_keys[slot] = src_keys[i];
+				dst_values[slot] = src_values[i];
+			}
+
+			u64* swap_keys = src_keys; src_keys = dst_keys; dst_keys = swap_keys;
+			u32* swap_values = src_values; src_values = dst_values; dst_values = swap_values;
+		}
+
+		if (src_keys != keys) {
+			memory::copy(keys, src_keys, count * sizeof(u64));
+			memory::copy(values, src_values, count * sizeof(u32));
+		}
+	}
+
+	constexpr u32 PARALLEL_MIN_COUNT = 16384; // below this the serial sort is faster
+	constexpr u32 PARALLEL_MAX_CHUNKS = 16;
+
+	// One pass of sort_u64_parallel: the input is cut into fixed chunks, each chunk counts its own
+	// digits, and the per-chunk offsets keep the scatter stable.
+	struct ParallelPass {
+		const u64* src_keys;
+		const u32* src_values;
+		u64*       dst_keys;
+		u32*       dst_values;
+		u32        count;
+		u32        chunk_size;
+		u32        shift;
+		u32        offsets[PARALLEL_MAX_CHUNKS][256];
+	};
+
+	inline void parallel_histogram(void* user, u32 begin, u32 end) {
+		ParallelPass* pass = (ParallelPass*)user;
+		for (u32 c = begin; c < end; c++) {
+			u32* histogram = pass->offsets[c];
+			memory::set(histogram, 0, 256 * sizeof(u32));
+			u32 lo = c * pass->chunk_size;
+			u32 hi = lo + pass->chunk_size < pass->count ? lo + pass->chunk_size : pass->count;
+			for (u32 i = lo; i < hi; i++) histogram[(pass->src_keys[i] >> pass->shift) & 0xFF]++;
+		}
+	}
+
+	inline void parallel_scatter(void* user, u32 begin, u32 end) {
+		ParallelPass* pass = (ParallelPass*)user;
+		for (u32 c = begin; c < end; c++) {
+			u32* slots = pass->offsets[c];
+			u32 lo = c * pass->chunk_size;
+			u32 hi = lo + pass->chunk_size < pass->count ? lo + pass->chunk_size : pass->count;
+			for (u32 i = lo; i < hi; i++) {
+				u32 slot = slots[(pass->src_keys[i] >> pass->shift) & 0xFF]++;
+				pass->dst_keys[slot] = pass->src_keys[i];
+				pass->dst_values[slot] = pass->src_values[i];
+			}
+		}
+	}
+
+	// sort_u64 with each pass's counting and scatter spread across the job system. Same contract and
+	// result; small inputs go to the serial sort. Call from the main thread, not from inside a job.
+	inline void sort_u64_parallel(u64* keys, u32* values, u64* temp_keys, u32* temp_values, u32 count) {
+		u32 chunk_count = jobs::worker_count() + 1;
+		if (chunk_count > PARALLEL_MAX_CHUNKS) chunk_count = PARALLEL_MAX_CHUNKS;
+		if (count < PARALLEL_MIN_COUNT || chunk_count < 2) {
+			sort_u64(keys, values, temp_keys, temp_values, count);
+			return;
+		}
+
+		ParallelPass pass;
+		pass.src_keys = keys;
+		pass.src_values = values;
+		pass.dst_keys = temp_keys;
+		pass.dst_values = temp_values;
+		pass.count = count;
+		pass.chunk_size = (count + chunk_count - 1) / chunk_count;
+
+		for (u32 shift = 0; shift < 64; shift += 8) {
+			pass.shift = shift;
+			jobs::parallel_for(chunk_count, 1, parallel_histogram, &pass);
+
+			u32 first = (pass.src_keys[0] >> shift) & 0xFF;
+			u32 first_total = 0;
+			for (u32 c = 0; c < chunk_count; c++) first_total += pass.offsets[c][first];
+			if (first_total == count) continue;
+
+			// Bucket-major, chunk-minor: equal digits keep their chunk order
+			u32 running = 0;
+			for (u32 b = 0; b < 256; b++) {
+				for (u32 c = 0; c < chunk_count; c++) {
+					u32 n = pass.offsets[c][b];
+					pass.offsets[c][b] = running;
+					running += n;
+				}
+			}
+			jobs::parallel_for(chunk_count, 1, parallel_scatter, &pass);
+
+			const u64* swap_keys = pass.src_keys; pass.src_keys = pass.dst_keys; pass.dst_keys = (u64*)swap_keys;
+			const u32* swap_values = pass.src_values; pass.src_values = pass.dst_values; pass.dst_values = (u32*)swap_values;
+		}
+
+		if (pass.src_keys != keys) {
+			memory::copy(keys, pass.src_keys, count * sizeof(u64));
+			memory::copy(values, pass.src_values, count * sizeof(u32));
+		}
+	}
+
+}
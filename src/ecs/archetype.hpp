@@ -0,0 +1,243 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/memory.hpp"
+#include "../core/array.hpp"
+#include "ecs.hpp"
+
+// Chunked archetype storage, an alternative to Store<T> for component sets that are always
+// iterated together. Entities with the same component set share fixed-size chunks where each
+// component is a contiguous column, so a multi-component pass is a linear walk with no sparse
+// lookups. Chunks stay packed: removal moves the archetype's last row into the hole.
+
+namespace ecs {
+
+	constexpr u32 ARCHETYPE_CHUNK_BYTES = (u32)KILOBYTES(16);
+	constexpr u32 ARCHETYPE_MAX_COMPONENTS = 8;
+	constexpr u32 ARCHETYPE_COLUMN_ALIGN = 16;
+
+	struct ComponentInfo {
+		u32 id;
+		u32 size;
+	};
+
+	struct Chunk {
+		byte* memory; // Entity column at offset 0, then one column per component
+		u32   count;
+	};
+
+	struct Archetype {
+		u64               mask;
+		u32               component_count;
+		ComponentInfo     components[ARCHETYPE_MAX_COMPONENTS];
+		u32               column_offsets[ARCHETYPE_MAX_COMPONENTS];
+		u32               chunk_capacity;
+		arr::Array<Chunk> chunks;
+	};
+
+	struct EntityLocation {
+		u32 archetype;
+		u32 chunk;
+		u32 row;
+	};
+
+	struct ArchetypeStorage {
+		arr::Array<Archetype*>     archetypes;
+		arr::Array<EntityLocation> locations; // indexed by entity_index
+	};
+
+	inline void archetype_storage_init(ArchetypeStorage* storage) {
+		*storage = {};
+	}
+
+	inline void archetype_storage_destroy(ArchetypeStorage* storage) {
+		for (usize i = 0; i < storage->archetypes.count; i++) {
+			Archetype* a = storage->archetypes.data[i];
+			for (usize c = 0; c < a->chunks.count; c++) {
+				memory::free(a->chunks.data[c].memory);
+			}
+			arr::array_destroy(&a->chunks);
+			memory::free(a);
+		}
+		arr::array_destroy(&storage->archetypes);
+		arr::array_destroy(&storage->locations);
+	}
+
+	inline u32 archetype_align(u32 offset) {
+		return (offset + ARCHETYPE_COLUMN_ALIGN - 1) & ~(ARCHETYPE_COLUMN_ALIGN - 1);
+	}
+
+	// Lays out columns for the largest row count that fits in one chunk.
+	inline void archetype_layout(Archetype* a) {
+		u32 row_bytes = sizeof(Entity);
+		for (u32 i = 0; i < a->component_count; i++) row_bytes += a->components[i].size;
+
+		u32 capacity = ARCHETYPE_CHUNK_BYTES / row_bytes;
+		for (;;) {
+			u32 offset = archetype_align(capacity * sizeof(Entity));
+			for (u32 i = 0; i < a->component_count; i++) {
+				a->column_offsets[i] = offset;
+				offset = archetype_align(offset + capacity * a->components[i].size);
+			}
+			if (offset <= ARCHETYPE_CHUNK_BYTES || capacity == 1) break;
+			capacity--;
+		}
+		a->chunk_capacity = capacity;
+	}
+
+	inline i32 archetype_column(const Archetype* a, u32 component) {
+		for (u32 i = 0; i < a->component_count; i++) {
+			if (a->components[i].id == component) return (i32)i;
+		}
+		return -1;
+	}
+
+	inline u32 archetype_find_or_create(ArchetypeStorage* storage, const ComponentInfo* components, u32 count) {
+		u64 mask = 0;
+		for (u32 i = 0; i < count; i++) mask |= 1ull << components[i].id;
+
+		for (usize i = 0; i < storage->archetypes.count; i++) {
+			if (storage->archetypes.data[i]->mask == mask) return (u32)i;
+		}
+
+		Archetype* a = (Archetype*)memory::malloc(sizeof(Archetype));
+		*a = {};
+		a->mask = mask;
+		a->component_count = count;
+		for (u32 i = 0; i < count; i++) a->components[i] = components[i];
+		archetype_layout(a);
+		arr::array_push(&storage->archetypes, a);
+		return (u32)storage->archetypes.count - 1;
+	}
+
+	inline Entity* chunk_entities(Chunk* chunk) {
+		return (Entity*)chunk->memory;
+	}
+
+	inline byte* chunk_column(const Archetype* a, Chunk* chunk, u32 column) {
+		return chunk->memory + a->column_offsets[column];
+	}
+
+	inline EntityLocation* archetype_location(ArchetypeStorage* storage, Entity e) {
+		u32 index = entity_index(e);
+		if (index >= storage->locations.count) return nullptr;
+		EntityLocation* loc = &storage->locations.data[index];
+		if (loc->archetype == INVALID_INDEX) return nullptr;
+		Chunk* chunk = &storage->archetypes.data[loc->archetype]->chunks.data[loc->chunk];
+		if (chunk_entities(chunk)[loc->row] != e) return nullptr;
+		return loc;
+	}
+
+	inline bool archetype_has_entity(ArchetypeStorage* storage, Entity e) {
+		return archetype_location(storage, e) != nullptr;
+	}
+
+	// Appends a row for e and returns its location. Component columns are left uninitialized.
+	inline EntityLocation archetype_push_row(ArchetypeStorage* storage, u32 archetype, Entity e) {
+		Archetype* a = storage->archetypes.data[archetype];
+		if (a->chunks.count == 0 || a->chunks.data[a->chunks.count - 1].count == a->chunk_capacity) {
+			Chunk chunk = {};
+			chunk.memory = (byte*)memory::malloc(ARCHETYPE_CHUNK_BYTES);
+			arr::array_push(&a->chunks, chunk);
+		}
+
+		u32 chunk_index = (u32)a->chunks.count - 1;
+		Chunk* chunk = &a->chunks.data[chunk_index];
+		u32 row = chunk->count++;
+		chunk_entities(chunk)[row] = e;
+
+		u32 index = entity_index(e);
+		if (index >= storage->locations.count) {
+			usize old_count = storage->locations.count;
+			arr::array_resize(&storage->locations, index + 1);
+			for (usize i = old_count; i < storage->locations.count; i++) {
+				storage->locations.data[i] = { INVALID_INDEX, 0, 0 };
+			}
+		}
+
+		EntityLocation loc = { archetype, chunk_index, row };
+		storage->locations.data[index] = loc;
+		return loc;
+	}
+
+	template<typename T>
+	T* archetype_get(ArchetypeStorage* storage, Entity e) {
+		EntityLocation* loc = archetype_location(storage, e);
+		if (!loc) return nullptr;
+		Archetype* a = storage->archetypes.data[loc->archetype];
+		i32 column = archetype_column(a, component_id<T>());
+		if (column < 0) return nullptr;
+		return (T*)chunk_column(a, &a->chunks.data[loc->chunk], (u32)column) + loc->row;
+	}
+
+	template<typename T>
+	void archetype_write(Archetype* a, Chunk* chunk, u32 row, const T& value) {
+		i32 column = archetype_column(a, component_id<T>());
+		((T*)chunk_column(a, chunk, (u32)column))[row] = value;
+	}
+
+	// Inserts e with exactly the components given. Entities already stored are left untouched.
+	template<typename... Ts>
+	bool archetype_add(ArchetypeStorage* storage, Entity e, const Ts&... values) {
+		static_assert(sizeof...(Ts) <= ARCHETYPE_MAX_COMPONENTS, "too many components for one archetype");
+		if (archetype_has_entity(storage, e)) return false;
+
+		ComponentInfo infos[] = { { component_id<Ts>(), (u32)sizeof(Ts) }... };
+		for (ComponentInfo info : infos) {
+			if (info.id >= MAX_COMPONENT_TYPES) return false;
+		}
+
+		u32 archetype = archetype_find_or_create(storage, infos, sizeof...(Ts));
+		EntityLocation loc = archetype_push_row(storage, archetype, e);
+		Archetype* a = storage->archetypes.data[archetype];
+		Chunk* chunk = &a->chunks.data[loc.chunk];
+		int expand[] = { (archetype_write(a, chunk, loc.row, values), 0)... };
+		(void)expand;
+		return true;
+	}
+
+	inline void archetype_remove(ArchetypeStorage* storage, Entity e) {
+		EntityLocation* loc = archetype_location(storage, e);
+		if (!loc) return;
+
+		Archetype* a = storage->archetypes.data[loc->archetype];
+		Chunk* dst = &a->chunks.data[loc->chunk];
+		Chunk* last = &a->chunks.data[a->chunks.count - 1];
+		u32 last_row = last->count - 1;
+
+		if (dst != last || loc->row != last_row) {
+			Entity moved = chunk_entities(last)[last_row];
+			chunk_entities(dst)[loc->row] = moved;
+			for (u32 c = 0; c < a->component_count; c++) {
+				u32 size = a->components[c].size;
+				memory::copy(chunk_column(a, dst, c) + loc->row * size,
+					chunk_column(a, last, c) + last_row * size, size);
+			}
+			storage->locations.data[entity_index(moved)] = *loc;
+		}
+
+		last->count--;
+		if (last->count == 0) {
+			memory::free(last->memory);
+			a->chunks.count--;
+		}
+		loc->archetype = INVALID_INDEX;
+	}
+
+	// Calls fn(const Entity*, Ts*..., count) once per chunk of every archetype holding all of Ts.
+	template<typename... Ts, typename Fn>
+	void archetype_each(ArchetypeStorage* storage, Fn fn) {
+		u64 want = component_mask<Ts...>();
+		for (usize i = 0; i < storage->archetypes.count; i++) {
+			Archetype* a = storage->archetypes.data[i];
+			if ((a->mask & want) != want) continue;
+			for (usize c = 0; c < a->chunks.count; c++) {
+				Chunk* chunk = &a->chunks.data[c];
+				fn((const Entity*)chunk_entities(chunk),
+					(Ts*)chunk_column(a, chunk, (u32)archetype_column(a, component_id<Ts>()))...,
+					chunk->count);
+			}
+		}
+	}
+
+}
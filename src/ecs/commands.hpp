@@ -0,0 +1,216 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/array.hpp"
+#include "../core/radix.hpp"
+#include "../core/jobs.hpp"
+#include "world.hpp"
+
+// Deferred structural changes. Systems record create/destroy/add/remove into the CommandBuffer of
+// the thread they run on and the queue applies every buffer at a sync point, when nothing is
+// iterating the stores. Recording never touches the World, so it is safe from any job.
+//
+// commands_apply coalesces: add/remove commands are sorted by (component, entity) and only the
+// last one per pair is applied, grouped by store. Destroys run after all adds and removes.
+
+namespace ecs {
+
+	// Slot of an entity created through a buffer; it gets a real handle when the buffer is applied.
+	struct PendingEntity {
+		u32 slot;
+	};
+
+	constexpr u8 COMMAND_ADD = 0;
+	constexpr u8 COMMAND_REMOVE = 1;
+	constexpr u8 COMMAND_DESTROY = 2;
+
+	using CommandApplyFn = void (*)(World* world, Entity e, const void* payload);
+
+	struct Command {
+		CommandApplyFn apply;     // null for COMMAND_DESTROY
+		Entity         entity;    // INVALID_ENTITY when the target is pending
+		u32            pending;   // PendingEntity slot, INVALID_INDEX for existing entities
+		u32            payload;   // byte offset of the component value for COMMAND_ADD
+		u8             type;
+		u8             component; // component_id, for ordering
+	};
+
+	struct CommandBuffer {
+		arr::Array<Command> commands;
+		arr::Array<byte>    payload;
+		arr::Array<Entity>  created;       // handle per PendingEntity slot, filled by commands_apply
+		u32                 pending_count;
+		bool                applied;       // created[] is readable until the next record
+	};
+
+	// A recorded command with its target resolved, built by commands_apply.
+	struct CommandOp {
+		const Command* command;
+		const void*    payload;
+		Entity         entity;
+	};
+
+	struct CommandQueue {
+		CommandBuffer         buffers[jobs::MAX_THREADS]; // indexed by jobs::thread_index()
+		arr::Array<CommandOp> ops;
+		arr::Array<u64>       keys;
+		arr::Array<u32>       values;
+		arr::Array<u64>       temp_keys;
+		arr::Array<u32>       temp_values;
+	};
+
+	inline void command_buffer_destroy(CommandBuffer* buffer) {
+		arr::array_destroy(&buffer->commands);
+		arr::array_destroy(&buffer->payload);
+		arr::array_destroy(&buffer->created);
+		*buffer = {};
+	}
+
+	inline void command_queue_destroy(CommandQueue* queue) {
+		for (u32 i = 0; i < jobs::MAX_THREADS; i++) command_buffer_destroy(&queue->buffers[i]);
+		arr::array_destroy(&queue->ops);
+		arr::array_destroy(&queue->keys);
+		arr::array_destroy(&queue->values);
+		arr::array_destroy(&queue->temp_keys);
+		arr::array_destroy(&queue->temp_values);
+	}
+
+	// The calling thread's buffer. Each thread only ever records into its own.
+	inline CommandBuffer* commands_local(CommandQueue* queue) {
+		return &queue->buffers[jobs::thread_index()];
+	}
+
+	inline void commands_begin_record(CommandBuffer* buffer) {
+		if (!buffer->applied) return;
+		arr::array_clear(&buffer->created);
+		buffer->pending_count = 0;
+		buffer->applied = false;
+	}
+
+	inline void commands_push(CommandBuffer* buffer, u8 type, u8 component, CommandApplyFn apply, Entity e, u32 pending, u32 payload) {
+		commands_begin_record(buffer);
+		Command c = {};
+		c.apply = apply;
+		c.entity = e;
+		c.pending = pending;
+		c.payload = payload;
+		c.type = type;
+		c.component = component;
+		arr::array_push(&buffer->commands, c);
+	}
+
+	// A deferred add carries a value, so it overwrites a component the entity already has.
+	template<typename T>
+	void command_add_apply(World* world, Entity e, const void* payload) {
+		Store<T>* store = world_store<T>(world);
+		T* existing = store_get(store, e);
+		if (!existing) {
+			store_add(store, e, *(const T*)payload);
+			return;
+		}
+		*existing = *(const T*)payload;
+		store_mark_changed(store, e);
+		store_notify(store, e, STORE_EVENT_SET);
+	}
+
+	template<typename T>
+	void command_remove_apply(World* world, Entity e, const void*) {
+		store_remove(world_store<T>(world), e);
+	}
+
+	template<typename T>
+	u32 commands_push_payload(CommandBuffer* buffer, const T& component) {
+		static_assert(alignof(T) <= 16, "component alignment above 16 is not supported");
+		usize offset = (buffer->payload.count + 15) & ~(usize)15;
+		arr::array_resize(&buffer->payload, offset + sizeof(T));
+		memory::copy(buffer->payload.data + offset, &component, sizeof(T));
+		return (u32)offset;
+	}
+
+	inline PendingEntity commands_create(CommandBuffer* buffer) {
+		commands_begin_record(buffer);
+		return { buffer->pending_count++ };
+	}
+
+	inline void commands_destroy(CommandBuffer* buffer, Entity e) {
+		commands_push(buffer, COMMAND_DESTROY, 0, nullptr, e, INVALID_INDEX, 0);
+	}
+
+	template<typename T>
+	void commands_add(CommandBuffer* buffer, Entity e, const T& component) {
+		u32 payload = commands_push_payload(buffer, component);
+		commands_push(buffer, COMMAND_ADD, (u8)component_id<T>(), command_add_apply<T>, e, INVALID_INDEX, payload);
+	}
+
+	template<typename T>
+	void commands_add(CommandBuffer* buffer, PendingEntity e, const T& component) {
+		u32 payload = commands_push_payload(buffer, component);
+		commands_push(buffer, COMMAND_ADD, (u8)component_id<T>(), command_add_apply<T>, INVALID_ENTITY, e.slot, payload);
+	}
+
+	template<typename T>
+	void commands_remove(CommandBuffer* buffer, Entity e) {
+		commands_push(buffer, COMMAND_REMOVE, (u8)component_id<T>(), command_remove_apply<T>, e, INVALID_INDEX, 0);
+	}
+
+	// Handle of an entity created through buffer, valid after commands_apply and until the buffer records again.
+	inline Entity commands_created(const CommandBuffer* buffer, PendingEntity e) {
+		if (!buffer->applied || e.slot >= buffer->created.count) return INVALID_ENTITY;
+		return buffer->created.data[e.slot];
+	}
+
+	// Applies and clears every buffer. Must run on one thread with no system iterating the World.
+	inline void commands_apply(CommandQueue* queue, World* world) {
+		arr::array_clear(&queue->ops);
+		arr::array_clear(&queue->keys);
+		arr::array_clear(&queue->values);
+
+		for (u32 b = 0; b < jobs::MAX_THREADS; b++) {
+			CommandBuffer* buffer = &queue->buffers[b];
+			if (buffer->applied) continue;
+
+			arr::array_resize(&buffer->created, buffer->pending_count);
+			for (u32 p = 0; p < buffer->pending_count; p++) buffer->created.data[p] = pool_create(&world->pool);
+
+			for (usize i = 0; i < buffer->commands.count; i++) {
+				const Command* c = &buffer->commands.data[i];
+				Entity e = c->pending == INVALID_INDEX ? c->entity : buffer->created.data[c->pending];
+				if (!pool_alive(&world->pool, e)) continue;
+
+				u32 seq = (u32)queue->ops.count;
+				arr::array_push(&queue->ops, CommandOp{ c, buffer->payload.data + c->payload, e });
+				if (c->type == COMMAND_DESTROY) continue;
+
+				// component | entity index | record order; the last command per (component, entity) wins
+				u64 key = ((u64)c->component << 56) | ((u64)entity_index(e) << 32) | seq;
+				arr::array_push(&queue->keys, key);
+				arr::array_push(&queue->values, seq);
+			}
+		}
+
+		u32 count = (u32)queue->keys.count;
+		arr::array_resize(&queue->temp_keys, count);
+		arr::array_resize(&queue->temp_values, count);
+		radix::sort_u64(queue->keys.data, queue->values.data, queue->temp_keys.data, queue->temp_values.data, count);
+
+		for (u32 i = 0; i < count; i++) {
+			if (i + 1 < count && (queue->keys.data[i + 1] >> 32) == (queue->keys.data[i] >> 32)) continue;
+			const CommandOp& op = queue->ops.data[queue->values.data[i]];
+			op.command->apply(world, op.entity, op.payload);
+		}
+
+		for (usize i = 0; i < queue->ops.count; i++) {
+			const CommandOp& op = queue->ops.data[i];
+			if (op.command->type == COMMAND_DESTROY) world_destroy_entity(world, op.entity);
+		}
+
+		for (u32 b = 0; b < jobs::MAX_THREADS; b++) {
+			CommandBuffer* buffer = &queue->buffers[b];
+			if (buffer->applied) continue;
+			arr::array_clear(&buffer->commands);
+			arr::array_clear(&buffer->payload);
+			buffer->applied = true;
+		}
+	}
+
+}
@@ -8,9 +8,9 @@ namespace ecs {
 
 	struct Transform {
 		vec3 position;
-		vec3 rotation; // euler angles (yaw, pitch, roll)
+		quat rotation; // normalized; euler angles only at the editor and scene file boundary
 		vec3 scale;
-		mat4 local_to_world;
+		mat3x4 local_to_world;
 	};
 
 	struct MeshInstance {
@@ -3,118 +3,528 @@
 #include "../core/types.hpp"
 #include "../core/memory.hpp"
 #include "../core/array.hpp"
+#include "../core/bits.hpp"
 
 namespace ecs {
 
+	// Handles pack a slot index (low bits) and the slot's generation (high bits).
+	// Releasing an entity bumps its slot generation, so stale handles fail pool_alive/store_has.
 	using Entity = u32;
 	constexpr Entity INVALID_ENTITY = ~0u;
-	constexpr u32 MAX_ENTITIES = 65536;
+	constexpr u32 INVALID_INDEX = ~0u;
+	constexpr u32 ENTITY_INDEX_BITS = 22;
+	constexpr u32 ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+	constexpr u32 ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+	constexpr u32 MAX_ENTITIES = ENTITY_INDEX_MASK; // hard limit, the all-ones index is reserved for INVALID_ENTITY
+	constexpr u32 DEFAULT_ENTITY_CAPACITY = 65536;
+
+	inline u32 entity_index(Entity e) { return e & ENTITY_INDEX_MASK; }
+	inline u32 entity_generation(Entity e) { return e >> ENTITY_INDEX_BITS; }
+	inline Entity entity_make(u32 index, u32 generation) {
+		return (generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+	}
+
+	// Process-wide component type ids, assigned on first use. Masks hold one bit per id.
+	constexpr u32 MAX_COMPONENT_TYPES = 64;
+
+	inline u32 next_component_id() {
+		static u32 counter = 0;
+		return counter++;
+	}
+
+	template<typename T>
+	u32 component_id() {
+		static u32 id = next_component_id();
+		return id;
+	}
+
+	template<typename... Ts>
+	u64 component_mask() {
+		u32 ids[] = { component_id<Ts>()... };
+		u64 mask = 0;
+		for (u32 id : ids) mask |= 1ull << id;
+		return mask;
+	}
 
 	struct EntityPool {
-		bool* alive;
+		arr::Array<u64> alive;        // bitset indexed by slot, grows with next_index
+		arr::Array<u16> generations;  // current generation per slot
 		arr::Array<u32> free_list;
 		u32 count;
-		u32 next_id;
+		u32 next_index;
+		u32 capacity;
 	};
 
-	inline void pool_init(EntityPool* pool) {
-		pool->alive = (bool*)memory::malloc(MAX_ENTITIES * sizeof(bool));
-		memory::set(pool->alive, 0, MAX_ENTITIES * sizeof(bool));
-		pool->free_list = {};
-		pool->count = 0;
-		pool->next_id = 0;
+	inline void pool_init(EntityPool* pool, u32 capacity = DEFAULT_ENTITY_CAPACITY) {
+		*pool = {};
+		pool->capacity = capacity < MAX_ENTITIES ? capacity : MAX_ENTITIES;
 	}
 
 	inline void pool_destroy(EntityPool* pool) {
-		memory::free(pool->alive);
+		arr::array_destroy(&pool->alive);
+		arr::array_destroy(&pool->generations);
 		arr::array_destroy(&pool->free_list);
 		*pool = {};
 	}
 
 	inline Entity pool_create(EntityPool* pool) {
-		u32 id;
+		u32 index;
 		if (pool->free_list.count > 0) {
-			id = arr::array_pop(&pool->free_list);
+			index = arr::array_pop(&pool->free_list);
 		} else {
-			id = pool->next_id++;
-			if (id >= MAX_ENTITIES) return INVALID_ENTITY;
+			index = pool->next_index;
+			if (index >= pool->capacity) return INVALID_ENTITY;
+			pool->next_index++;
+			arr::array_push(&pool->generations, (u16)0);
+			if (pool->alive.count < bits::word_count(pool->next_index)) {
+				arr::array_push(&pool->alive, 0ull);
+			}
 		}
-		pool->alive[id] = true;
+		bits::set(pool->alive.data, index);
 		pool->count++;
-		return id;
+		return entity_make(index, pool->generations.data[index]);
+	}
+
+	inline bool pool_alive(const EntityPool* pool, Entity e) {
+		u32 index = entity_index(e);
+		return index < pool->next_index
+			&& bits::test(pool->alive.data, index)
+			&& pool->generations.data[index] == entity_generation(e);
 	}
 
 	inline void pool_release(EntityPool* pool, Entity e) {
-		if (e >= MAX_ENTITIES || !pool->alive[e]) return;
-		pool->alive[e] = false;
-		arr::array_push(&pool->free_list, e);
+		if (!pool_alive(pool, e)) return;
+		u32 index = entity_index(e);
+		bits::clear(pool->alive.data, index);
+		pool->generations.data[index] = (u16)((pool->generations.data[index] + 1) & ENTITY_GENERATION_MASK);
+		arr::array_push(&pool->free_list, index);
 		pool->count--;
 	}
 
-	inline bool pool_alive(const EntityPool* pool, Entity e) {
-		return e < MAX_ENTITIES && pool->alive[e];
+	// Creates up to count entities into out and returns how many were created. Free slots are
+	// reused first; the rest come from one contiguous run of fresh indices.
+	inline u32 pool_create_n(EntityPool* pool, u32 count, Entity* out) {
+		u32 created = 0;
+		while (created < count && pool->free_list.count > 0) {
+			u32 index = arr::array_pop(&pool->free_list);
+			bits::set(pool->alive.data, index);
+			out[created++] = entity_make(index, pool->generations.data[index]);
+		}
+
+		u32 fresh = count - created;
+		if (fresh > pool->capacity - pool->next_index) fresh = pool->capacity - pool->next_index;
+		if (fresh > 0) {
+			u32 first = pool->next_index;
+			pool->next_index += fresh;
+			arr::array_resize(&pool->generations, pool->next_index);
+			memory::set(pool->generations.data + first, 0, fresh * sizeof(u16));
+			u32 words = bits::word_count(pool->next_index);
+			if (pool->alive.count < words) {
+				usize old_words = pool->alive.count;
+				arr::array_resize(&pool->alive, words);
+				memory::set(pool->alive.data + old_words, 0, (words - old_words) * sizeof(u64));
+			}
+			bits::set_range(pool->alive.data, first, pool->next_index);
+			for (u32 i = 0; i < fresh; i++) out[created++] = entity_make(first + i, 0);
+		}
+
+		pool->count += created;
+		return created;
+	}
+
+	// Releases every live entity. Each slot's generation is bumped so outstanding handles go stale,
+	// and all slots go back on the free list.
+	inline void pool_clear(EntityPool* pool) {
+		for (u32 i = 0; i < pool->next_index; i++) {
+			pool->generations.data[i] = (u16)((pool->generations.data[i] + bits::test(pool->alive.data, i)) & ENTITY_GENERATION_MASK);
+		}
+		memory::set(pool->alive.data, 0, pool->alive.count * sizeof(u64));
+		arr::array_resize(&pool->free_list, pool->next_index);
+		for (u32 i = 0; i < pool->next_index; i++) pool->free_list.data[i] = pool->next_index - 1 - i;
+		pool->count = 0;
+	}
+
+	// Calls fn(Entity) for every live entity, a 64-slot word at a time.
+	template<typename Fn>
+	void pool_each(const EntityPool* pool, Fn fn) {
+		for (u32 w = 0; w < (u32)pool->alive.count; w++) {
+			u64 live = pool->alive.data[w];
+			while (live) {
+				u32 index = w * 64 + bits::ctz64(live);
+				live &= live - 1;
+				fn(entity_make(index, pool->generations.data[index]));
+			}
+		}
+	}
+
+	// Entity index -> dense index map split into fixed pages that are allocated on first write,
+	// so memory follows the entity ranges a store actually touches rather than world capacity.
+	constexpr u32 SPARSE_PAGE_BITS = 12;
+	constexpr u32 SPARSE_PAGE_SIZE = 1u << SPARSE_PAGE_BITS;
+	constexpr u32 SPARSE_PAGE_MASK = SPARSE_PAGE_SIZE - 1;
+
+	struct SparseIndex {
+		u32** pages;
+		u32   page_count;
+	};
+
+	inline void sparse_init(SparseIndex* sparse, u32 capacity) {
+		sparse->page_count = (capacity + SPARSE_PAGE_SIZE - 1) >> SPARSE_PAGE_BITS;
+		sparse->pages = (u32**)memory::malloc(sparse->page_count * sizeof(u32*));
+		memory::set(sparse->pages, 0, sparse->page_count * sizeof(u32*));
+	}
+
+	inline void sparse_destroy(SparseIndex* sparse) {
+		for (u32 p = 0; p < sparse->page_count; p++) {
+			if (sparse->pages[p]) memory::free(sparse->pages[p]);
+		}
+		memory::free(sparse->pages);
+		*sparse = {};
+	}
+
+	inline u32 sparse_get(const SparseIndex* sparse, u32 index) {
+		u32 page = index >> SPARSE_PAGE_BITS;
+		if (page >= sparse->page_count || !sparse->pages[page]) return INVALID_INDEX;
+		return sparse->pages[page][index & SPARSE_PAGE_MASK];
+	}
+
+	// Drops every page; cost follows the pages in use, not the entry count.
+	inline void sparse_clear(SparseIndex* sparse) {
+		for (u32 p = 0; p < sparse->page_count; p++) {
+			if (sparse->pages[p]) memory::free(sparse->pages[p]);
+			sparse->pages[p] = nullptr;
+		}
+	}
+
+	inline void sparse_set(SparseIndex* sparse, u32 index, u32 value) {
+		u32 page = index >> SPARSE_PAGE_BITS;
+		if (page >= sparse->page_count) return;
+		if (!sparse->pages[page]) {
+			sparse->pages[page] = (u32*)memory::malloc(SPARSE_PAGE_SIZE * sizeof(u32));
+			memory::set(sparse->pages[page], 0xFF, SPARSE_PAGE_SIZE * sizeof(u32)); // fill with INVALID_INDEX
+		}
+		sparse->pages[page][index & SPARSE_PAGE_MASK] = value;
+	}
+
+	// Store observers are called synchronously, on the thread making the change, after it is made.
+	// Derived structures (display lists, name or spatial indices) hook these to update incrementally
+	// instead of rescanning. STORE_EVENT_SET is not raised by plain writes through store_get; code
+	// that edits a component in place and wants observers to know calls store_notify itself.
+	constexpr u32 STORE_EVENT_ADD = 0;
+	constexpr u32 STORE_EVENT_REMOVE = 1;
+	constexpr u32 STORE_EVENT_SET = 2;
+	constexpr u32 STORE_EVENT_CLEAR = 3; // entity is INVALID_ENTITY
+	constexpr u32 MAX_STORE_OBSERVERS = 4;
+
+	using StoreObserverFn = void (*)(void* user, Entity e, u32 event);
+
+	struct StoreObservers {
+		StoreObserverFn fns[MAX_STORE_OBSERVERS];
+		void*           users[MAX_STORE_OBSERVERS];
+		u32             count;
+	};
+
+	inline bool observers_add(StoreObservers* observers, StoreObserverFn fn, void* user) {
+		if (observers->count >= MAX_STORE_OBSERVERS) return false;
+		observers->fns[observers->count] = fn;
+		observers->users[observers->count] = user;
+		observers->count++;
+		return true;
+	}
+
+	inline void observers_remove(StoreObservers* observers, StoreObserverFn fn, void* user) {
+		for (u32 i = 0; i < observers->count; i++) {
+			if (observers->fns[i] != fn || observers->users[i] != user) continue;
+			observers->count--;
+			observers->fns[i] = observers->fns[observers->count];
+			observers->users[i] = observers->users[observers->count];
+			return;
+		}
+	}
+
+	inline void observers_notify(const StoreObservers* observers, Entity e, u32 event) {
+		for (u32 i = 0; i < observers->count; i++) observers->fns[i](observers->users[i], e, event);
 	}
 
 	template<typename T>
 	struct Store {
 		arr::Array<T>      data;
 		arr::Array<Entity> entities;
-		u32*               sparse;
+		SparseIndex        sparse;
+		arr::Array<u64>    changed;       // bitset over dense indices, follows entries through swap-removal
+		u32                changed_count;
+		u32                version;       // bumped whenever dense indices move, for caches keyed on them
+		StoreObservers     observers;
 	};
 
 	template<typename T>
-	void store_init(Store<T>* store) {
+	void store_init(Store<T>* store, u32 capacity = DEFAULT_ENTITY_CAPACITY) {
 		store->data = {};
 		store->entities = {};
-		store->sparse = (u32*)memory::malloc(MAX_ENTITIES * sizeof(u32));
-		memory::set(store->sparse, 0xFF, MAX_ENTITIES * sizeof(u32)); // fill with INVALID_ENTITY
+		sparse_init(&store->sparse, capacity);
+		store->changed = {};
+		store->changed_count = 0;
+		store->version = 0;
+		store->observers = {};
 	}
 
 	template<typename T>
 	void store_destroy(Store<T>* store) {
 		arr::array_destroy(&store->data);
 		arr::array_destroy(&store->entities);
-		memory::free(store->sparse);
-		store->sparse = nullptr;
+		sparse_destroy(&store->sparse);
+		arr::array_destroy(&store->changed);
+		store->changed_count = 0;
+	}
+
+	template<typename T>
+	bool store_observe(Store<T>* store, StoreObserverFn fn, void* user) {
+		return observers_add(&store->observers, fn, user);
+	}
+
+	template<typename T>
+	void store_unobserve(Store<T>* store, StoreObserverFn fn, void* user) {
+		observers_remove(&store->observers, fn, user);
+	}
+
+	template<typename T>
+	void store_notify(const Store<T>* store, Entity e, u32 event) {
+		observers_notify(&store->observers, e, event);
+	}
+
+	template<typename T>
+	void store_mark_changed_at(Store<T>* store, u32 dense_index) {
+		if (bits::test(store->changed.data, dense_index)) return;
+		bits::set(store->changed.data, dense_index);
+		store->changed_count++;
+	}
+
+	// Writes through store_get are not tracked; callers that modify a component mark it here.
+	template<typename T>
+	void store_mark_changed(Store<T>* store, Entity e) {
+		u32 dense_index = sparse_get(&store->sparse, entity_index(e));
+		if (dense_index == INVALID_INDEX || store->entities.data[dense_index] != e) return;
+		store_mark_changed_at(store, dense_index);
+	}
+
+	template<typename T>
+	bool store_changed(const Store<T>* store, Entity e) {
+		u32 dense_index = sparse_get(&store->sparse, entity_index(e));
+		if (dense_index == INVALID_INDEX || store->entities.data[dense_index] != e) return false;
+		return bits::test(store->changed.data, dense_index);
+	}
+
+	template<typename T>
+	void store_clear_changed(Store<T>* store) {
+		if (store->changed_count == 0) return;
+		memory::set(store->changed.data, 0, store->changed.count * sizeof(u64));
+		store->changed_count = 0;
+	}
+
+	// Calls fn(u32 dense_index) for changed entries in bitset words [word_begin, word_end).
+	template<typename T, typename Fn>
+	void store_each_changed_range(const Store<T>* store, u32 word_begin, u32 word_end, Fn fn) {
+		for (u32 w = word_begin; w < word_end; w++) {
+			u64 word = store->changed.data[w];
+			while (word) {
+				fn(w * 64 + bits::ctz64(word));
+				word &= word - 1;
+			}
+		}
+	}
+
+	template<typename T, typename Fn>
+	void store_each_changed(const Store<T>* store, Fn fn) {
+		if (store->changed_count == 0) return;
+		store_each_changed_range(store, 0, (u32)store->changed.count, fn);
 	}
 
 	template<typename T>
 	bool store_has(const Store<T>* store, Entity e) {
-		return e < MAX_ENTITIES && store->sparse[e] != INVALID_ENTITY;
+		u32 dense_index = sparse_get(&store->sparse, entity_index(e));
+		return dense_index != INVALID_INDEX && store->entities.data[dense_index] == e;
 	}
 
 	template<typename T>
 	T* store_get(Store<T>* store, Entity e) {
-		if (!store_has(store, e)) return nullptr;
-		return &store->data.data[store->sparse[e]];
+		u32 dense_index = sparse_get(&store->sparse, entity_index(e));
+		if (dense_index == INVALID_INDEX || store->entities.data[dense_index] != e) return nullptr;
+		return &store->data.data[dense_index];
 	}
 
 	template<typename T>
 	T* store_add(Store<T>* store, Entity e, const T& component) {
 		if (store_has(store, e)) return store_get(store, e);
+		if (entity_index(e) >= store->sparse.page_count * SPARSE_PAGE_SIZE) return nullptr;
 		u32 dense_index = (u32)store->data.count;
 		arr::array_push(&store->data, component);
 		arr::array_push(&store->entities, e);
-		store->sparse[e] = dense_index;
+		sparse_set(&store->sparse, entity_index(e), dense_index);
+		if (store->changed.count < bits::word_count(dense_index + 1)) {
+			arr::array_push(&store->changed, 0ull);
+		}
+		store_mark_changed_at(store, dense_index);
+		store->version++;
+		store_notify(store, e, STORE_EVENT_ADD);
 		return &store->data.data[dense_index];
 	}
 
+	template<typename T>
+	void store_reserve(Store<T>* store, usize capacity) {
+		arr::array_reserve(&store->data, capacity);
+		arr::array_reserve(&store->entities, capacity);
+		arr::array_reserve(&store->changed, bits::word_count((u32)capacity));
+	}
+
+	// Appends count components with one reserve and one copy per array. Entities already in the
+	// store are updated in place, the rest are appended in order and marked changed.
+	template<typename T>
+	void store_add_n(Store<T>* store, const Entity* entities, const T* components, u32 count) {
+		u32 first = (u32)store->data.count;
+		store_reserve(store, first + count);
+
+		u32 dense_index = first;
+		for (u32 i = 0; i < count; i++) {
+			Entity e = entities[i];
+			if (entity_index(e) >= store->sparse.page_count * SPARSE_PAGE_SIZE) continue;
+			u32 existing = sparse_get(&store->sparse, entity_index(e));
+			if (existing != INVALID_INDEX && existing < first && store->entities.data[existing] == e) {
+				store->data.data[existing] = components[i];
+				continue;
+			}
+			if (existing != INVALID_INDEX && existing >= first) continue; // listed twice, the gather keeps the last
+			sparse_set(&store->sparse, entity_index(e), dense_index++);
+		}
+
+		u32 added = dense_index - first;
+		if (added == count) {
+			memory::copy(store->data.data + first, components, count * sizeof(T));
+			memory::copy(store->entities.data + first, entities, count * sizeof(Entity));
+		} else {
+			// Some entries were skipped; gather the ones that received a dense slot
+			for (u32 i = 0; i < count; i++) {
+				u32 di = sparse_get(&store->sparse, entity_index(entities[i]));
+				if (di == INVALID_INDEX || di < first) continue;
+				store->data.data[di] = components[i];
+				store->entities.data[di] = entities[i];
+			}
+		}
+		store->data.count = dense_index;
+		store->entities.count = dense_index;
+
+		usize words = bits::word_count(dense_index);
+		if (store->changed.count < words) {
+			usize old_words = store->changed.count;
+			arr::array_resize(&store->changed, words);
+			memory::set(store->changed.data + old_words, 0, (words - old_words) * sizeof(u64));
+		}
+		for (u32 i = first; i < dense_index; i++) store_mark_changed_at(store, i);
+		store->version++;
+
+		// Observers run once the store is consistent again: updates first, then the appended entries
+		if (store->observers.count > 0) {
+			for (u32 i = 0; i < count; i++) {
+				u32 di = sparse_get(&store->sparse, entity_index(entities[i]));
+				if (di < first && store->entities.data[di] == entities[i]) store_notify(store, entities[i], STORE_EVENT_SET);
+			}
+			for (u32 i = first; i < dense_index; i++) store_notify(store, store->entities.data[i], STORE_EVENT_ADD);
+		}
+	}
+
+	// Empties the store without visiting entries.
+	template<typename T>
+	void store_clear(Store<T>* store) {
+		arr::array_clear(&store->data);
+		arr::array_clear(&store->entities);
+		sparse_clear(&store->sparse);
+		store_clear_changed(store);
+		store->version++;
+		store_notify(store, INVALID_ENTITY, STORE_EVENT_CLEAR);
+	}
+
 	template<typename T>
 	void store_remove(Store<T>* store, Entity e) {
 		if (!store_has(store, e)) return;
-		u32 dense_index = store->sparse[e];
+		u32 dense_index = sparse_get(&store->sparse, entity_index(e));
 		u32 last_index = (u32)store->data.count - 1;
+		bool removed_changed = bits::test(store->changed.data, dense_index);
 
 		if (dense_index != last_index) {
 			Entity last_entity = store->entities.data[last_index];
 			store->data.data[dense_index] = store->data.data[last_index];
 			store->entities.data[dense_index] = last_entity;
-			store->sparse[last_entity] = dense_index;
+			sparse_set(&store->sparse, entity_index(last_entity), dense_index);
+			if (bits::test(store->changed.data, last_index)) bits::set(store->changed.data, dense_index);
+			else bits::clear(store->changed.data, dense_index);
 		}
 
+		bits::clear(store->changed.data, last_index);
+		if (removed_changed) store->changed_count--;
+		store->version++;
+
 		store->data.count--;
 		store->entities.count--;
-		store->sparse[e] = INVALID_ENTITY;
+		sparse_set(&store->sparse, entity_index(e), INVALID_INDEX);
+		store_notify(store, e, STORE_EVENT_REMOVE);
+	}
+
+	// Removes the listed entities. Batches of at least an eighth of the store go in one compaction
+	// pass that keeps survivors in their relative order; smaller ones swap-remove, which moves
+	// entries from the end into the holes. Either way the version bumps, so sorted views
+	// (store_groups_update) re-sort.
+	template<typename T>
+	void store_remove_n(Store<T>* store, const Entity* entities, u32 count) {
+		u32 size = (u32)store->data.count;
+		if (count == 0 || size == 0) return;
+		if ((u64)count * 8 < size) {
+			for (u32 i = 0; i < count; i++) store_remove(store, entities[i]);
+			return;
+		}
+
+		usize words = bits::word_count(size);
+		u64* removed = (u64*)memory::malloc(words * sizeof(u64));
+		memory::set(removed, 0, words * sizeof(u64));
+		u32 removed_count = 0;
+		Entity* removed_entities = store->observers.count > 0 ? (Entity*)memory::malloc(count * sizeof(Entity)) : nullptr;
+		for (u32 i = 0; i < count; i++) {
+			u32 dense_index = sparse_get(&store->sparse, entity_index(entities[i]));
+			if (dense_index == INVALID_INDEX || store->entities.data[dense_index] != entities[i]) continue;
+			bits::set(removed, dense_index);
+			sparse_set(&store->sparse, entity_index(entities[i]), INVALID_INDEX);
+			if (removed_entities) removed_entities[removed_count] = entities[i];
+			removed_count++;
+		}
+
+		if (removed_count > 0) {
+			u32 write = 0;
+			for (u32 read = 0; read < size; read++) {
+				bool changed = bits::test(store->changed.data, read);
+				if (bits::test(removed, read)) {
+					if (changed) store->changed_count--;
+					continue;
+				}
+				if (write != read) {
+					store->data.data[write] = store->data.data[read];
+					store->entities.data[write] = store->entities.data[read];
+					sparse_set(&store->sparse, entity_index(store->entities.data[write]), write);
+					if (changed) bits::set(store->changed.data, write);
+					else bits::clear(store->changed.data, write);
+				}
+				write++;
+			}
+			for (u32 i = write; i < size; i++) bits::clear(store->changed.data, i);
+
+			store->data.count = write;
+			store->entities.count = write;
+			store->version++;
+
+			for (u32 i = 0; removed_entities && i < removed_count; i++) {
+				store_notify(store, removed_entities[i], STORE_EVENT_REMOVE);
+			}
+		}
+
+		memory::free(removed);
+		if (removed_entities) memory::free(removed_entities);
 	}
 
 }
@@ -0,0 +1,396 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/array.hpp"
+#include "../core/jobs.hpp"
+#include "world.hpp"
+
+// Transform hierarchy laid out by level. Parent links live in HierarchyNode; HierarchyLevels is
+// a derived, breadth-first ordering of (child, parent) links where level L holds every node at
+// depth L. It observes the hierarchy store and patches itself: a reparent moves only the affected
+// subtree between levels, found through per-node child lists, and a removed parent turns its
+// children into roots. Every node whose parent link changes is marked changed in the transforms
+// store so its world matrix is recomputed. Transform adds and removes only move dense indices,
+// which are re-resolved in one pass over the links. Each level depends only on the levels above
+// it, so world matrices are composed one level at a time with the level split across workers.
+// There is no depth limit.
+
+namespace ecs {
+
+	struct HierarchyLink {
+		Entity child;
+		Entity parent;
+		u32    transform;        // dense index in World::transforms, INVALID_INDEX without one
+		u32    parent_transform; // likewise for the parent
+	};
+
+	// Per entity index. A node is listed under its recorded parent's index even while that parent
+	// isn't in the hierarchy (not loaded yet, or destroyed); it is linked, with depth > 0, only when
+	// the entity at that index is the parent it names.
+	struct HierarchyLevelNode {
+		Entity entity;       // INVALID_ENTITY when the index isn't tracked
+		Entity parent;       // recorded parent, INVALID_ENTITY for none
+		u32    depth;        // 0 for roots and unlinked nodes
+		u32    slot;         // index in by_depth[depth - 1]
+		u32    first_child;  // entity indices, INVALID_INDEX terminated
+		u32    next_sibling;
+		u32    prev_sibling;
+	};
+
+	struct HierarchyEvent {
+		Entity entity;
+		u32    event;
+	};
+
+	struct HierarchyLevels {
+		arr::Array<arr::Array<HierarchyLink>> by_depth; // by_depth[d - 1] holds the links of depth d nodes
+		arr::Array<HierarchyLevelNode>        nodes;    // by entity index
+		arr::Array<HierarchyEvent>            pending;  // store events not applied yet
+		arr::Array<Entity>                    path;     // scratch
+		arr::Array<u32>                       stack;    // scratch
+		World*                                world;
+		u32                                   transforms_version;
+		bool                                  built;
+	};
+
+	// Queued rather than applied: hierarchy edits happen while the simulation is joined, and the
+	// levels are only touched from hierarchy_levels_update inside it.
+	inline void hierarchy_levels_on_event(void* user, Entity e, u32 event) {
+		HierarchyLevels* levels = (HierarchyLevels*)user;
+		if (event == STORE_EVENT_CLEAR) arr::array_clear(&levels->pending);
+		arr::array_push(&levels->pending, { e, event });
+	}
+
+	inline void hierarchy_levels_init(HierarchyLevels* levels, World* world) {
+		*levels = {};
+		levels->world = world;
+		store_observe(&world->hierarchy, hierarchy_levels_on_event, levels);
+	}
+
+	inline void hierarchy_levels_destroy(HierarchyLevels* levels) {
+		if (levels->world) store_unobserve(&levels->world->hierarchy, hierarchy_levels_on_event, levels);
+		for (usize d = 0; d < levels->by_depth.count; d++) arr::array_destroy(&levels->by_depth.data[d]);
+		arr::array_destroy(&levels->by_depth);
+		arr::array_destroy(&levels->nodes);
+		arr::array_destroy(&levels->pending);
+		arr::array_destroy(&levels->path);
+		arr::array_destroy(&levels->stack);
+		*levels = {};
+	}
+
+	inline bool hierarchy_is_ancestor(World* world, Entity ancestor, Entity descendant) {
+		u32 guard = (u32)world->hierarchy.data.count;
+		Entity cur = descendant;
+		while (guard--) {
+			HierarchyNode* hn = store_get(&world->hierarchy, cur);
+			if (!hn || hn->parent == INVALID_ENTITY) return false;
+			if (hn->parent == ancestor) return true;
+			cur = hn->parent;
+		}
+		return false;
+	}
+
+	// Returns false if the link would create a cycle. parent may be INVALID_ENTITY to detach.
+	inline bool hierarchy_set_parent(World* world, Entity child, Entity parent) {
+		if (child == parent) return false;
+		HierarchyNode* hn = store_get(&world->hierarchy, child);
+		if (!hn) return false;
+		if (parent != INVALID_ENTITY && hierarchy_is_ancestor(world, child, parent)) return false;
+		if (hn->parent == parent) return true;
+
+		hn->parent = parent;
+		world->hierarchy.version++;
+		store_notify(&world->hierarchy, child, STORE_EVENT_SET);
+		return true;
+	}
+
+	inline u32 hierarchy_transform_index(const Store<Transform>* transforms, Entity e) {
+		if (e == INVALID_ENTITY) return INVALID_INDEX;
+		u32 ti = sparse_get(&transforms->sparse, entity_index(e));
+		return ti != INVALID_INDEX && transforms->entities.data[ti] == e ? ti : INVALID_INDEX;
+	}
+
+	inline HierarchyLevelNode* hierarchy_node(HierarchyLevels* levels, u32 index) {
+		if (index >= levels->nodes.count) {
+			usize old_count = levels->nodes.count;
+			usize count = old_count ? old_count : 64;
+			while (count <= index) count *= 2;
+			arr::array_resize(&levels->nodes, count);
+			for (usize i = old_count; i < count; i++) {
+				levels->nodes.data[i] = { INVALID_ENTITY, INVALID_ENTITY, 0, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX };
+			}
+		}
+		return &levels->nodes.data[index];
+	}
+
+	inline bool hierarchy_node_tracked(HierarchyLevels* levels, Entity e) {
+		return entity_index(e) < levels->nodes.count && levels->nodes.data[entity_index(e)].entity == e;
+	}
+
+	// Whether linking index to parent would close a loop: walks the parent's linked ancestors
+	inline bool hierarchy_levels_cycle(HierarchyLevels* levels, u32 index, Entity parent) {
+		u32 cur = entity_index(parent);
+		while (cur != index) {
+			const HierarchyLevelNode& node = levels->nodes.data[cur];
+			if (node.depth == 0) return false;
+			cur = entity_index(node.parent);
+		}
+		return true;
+	}
+
+	inline void hierarchy_list_insert(HierarchyLevels* levels, u32 index) {
+		u32 parent_index = entity_index(levels->nodes.data[index].parent);
+		HierarchyLevelNode* parent = hierarchy_node(levels, parent_index);
+		HierarchyLevelNode* node = &levels->nodes.data[index];
+		node->prev_sibling = INVALID_INDEX;
+		node->next_sibling = parent->first_child;
+		if (parent->first_child != INVALID_INDEX) levels->nodes.data[parent->first_child].prev_sibling = index;
+		parent->first_child = index;
+	}
+
+	inline void hierarchy_list_remove(HierarchyLevels* levels, u32 index) {
+		HierarchyLevelNode* node = &levels->nodes.data[index];
+		if (node->prev_sibling != INVALID_INDEX) levels->nodes.data[node->prev_sibling].next_sibling = node->next_sibling;
+		else levels->nodes.data[entity_index(node->parent)].first_child = node->next_sibling;
+		if (node->next_sibling != INVALID_INDEX) levels->nodes.data[node->next_sibling].prev_sibling = node->prev_sibling;
+		node->prev_sibling = node->next_sibling = INVALID_INDEX;
+	}
+
+	inline bool hierarchy_link_resolved(const HierarchyLink& link) {
+		return link.transform != INVALID_INDEX && link.parent_transform != INVALID_INDEX;
+	}
+
+	// Moves one node's link to depth d, re-resolving it since its parent may have changed; 0 unlinks
+	// it. A link whose parent transform came or went since it was last resolved marks the node.
+	inline void hierarchy_level_place(HierarchyLevels* levels, u32 index, u32 d) {
+		HierarchyLevelNode* node = &levels->nodes.data[index];
+		bool was_resolved = false;
+		if (node->depth > 0) {
+			arr::Array<HierarchyLink>* level = &levels->by_depth.data[node->depth - 1];
+			was_resolved = hierarchy_link_resolved(level->data[node->slot]);
+			HierarchyLink last = level->data[--level->count];
+			if (node->slot < level->count) {
+				level->data[node->slot] = last;
+				levels->nodes.data[entity_index(last.child)].slot = node->slot;
+			}
+		}
+		node->depth = d;
+		node->slot = INVALID_INDEX;
+		if (d == 0) return;
+
+		if (d > levels->by_depth.count) {
+			usize old_count = levels->by_depth.count;
+			if (d > levels->by_depth.capacity) arr::array_reserve(&levels->by_depth, d > old_count * 2 ? d : old_count * 2);
+			arr::array_resize(&levels->by_depth, d);
+			for (usize i = old_count; i < d; i++) levels->by_depth.data[i] = {};
+		}
+		Store<Transform>* transforms = &levels->world->transforms;
+		arr::Array<HierarchyLink>* level = &levels->by_depth.data[d - 1];
+		HierarchyLink link = { node->entity, node->parent, hierarchy_transform_index(transforms, node->entity), hierarchy_transform_index(transforms, node->parent) };
+		if (hierarchy_link_resolved(link) != was_resolved && link.transform != INVALID_INDEX) store_mark_changed_at(transforms, link.transform);
+		node->slot = (u32)level->count;
+		arr::array_push(level, link);
+	}
+
+	// Places index at depth d and shifts its linked descendants along with it
+	inline void hierarchy_levels_move(HierarchyLevels* levels, u32 index, u32 d) {
+		u32 old_depth = levels->nodes.data[index].depth;
+		hierarchy_level_place(levels, index, d);
+		if (old_depth == d) return;
+
+		arr::array_clear(&levels->stack);
+		arr::array_push(&levels->stack, index);
+		while (levels->stack.count > 0) {
+			u32 cur = arr::array_pop(&levels->stack);
+			const HierarchyLevelNode& node = levels->nodes.data[cur];
+			Entity e = node.entity;
+			u32 child_depth = node.depth + 1;
+			for (u32 c = node.first_child; c != INVALID_INDEX; c = levels->nodes.data[c].next_sibling) {
+				if (levels->nodes.data[c].parent != e) continue;
+				hierarchy_level_place(levels, c, child_depth);
+				arr::array_push(&levels->stack, c);
+			}
+		}
+	}
+
+	// Links a tracked, unlisted node to parent (if any) and settles its subtree at the right depth.
+	// A node without linked children can't close a loop, so fresh nodes skip the ancestor walk.
+	inline void hierarchy_levels_link(HierarchyLevels* levels, u32 index, Entity parent, bool has_children) {
+		if (has_children && parent != INVALID_ENTITY && hierarchy_node_tracked(levels, parent) && hierarchy_levels_cycle(levels, index, parent)) {
+			parent = INVALID_ENTITY; // only reachable through unchecked edits; the node stays a root
+		}
+		levels->nodes.data[index].parent = parent;
+		if (parent != INVALID_ENTITY) hierarchy_list_insert(levels, index);
+
+		u32 d = parent != INVALID_ENTITY && hierarchy_node_tracked(levels, parent) ? levels->nodes.data[entity_index(parent)].depth + 1 : 0;
+		hierarchy_levels_move(levels, index, d);
+		store_mark_changed(&levels->world->transforms, levels->nodes.data[index].entity);
+	}
+
+	// Starts tracking e and its untracked ancestors, top-down, so a subtree arriving in one batch
+	// settles without being moved again. Children already listed under e's index are adopted.
+	inline void hierarchy_levels_track(HierarchyLevels* levels, Entity e) {
+		Store<HierarchyNode>* hierarchy = &levels->world->hierarchy;
+		arr::array_clear(&levels->path);
+		for (Entity cur = e; cur != INVALID_ENTITY && !hierarchy_node_tracked(levels, cur) && levels->path.count <= hierarchy->data.count;) {
+			HierarchyNode* hn = store_get(hierarchy, cur);
+			if (!hn) break;
+			arr::array_push(&levels->path, cur);
+			cur = hn->parent;
+		}
+
+		while (levels->path.count > 0) {
+			Entity cur = arr::array_pop(&levels->path);
+			if (hierarchy_node_tracked(levels, cur)) continue;
+			u32 index = entity_index(cur);
+			HierarchyLevelNode* node = hierarchy_node(levels, index);
+			node->entity = cur;
+			node->parent = INVALID_ENTITY;
+			node->depth = 0;
+			hierarchy_levels_link(levels, index, store_get(hierarchy, cur)->parent, false);
+
+			for (u32 c = levels->nodes.data[index].first_child; c != INVALID_INDEX;) {
+				u32 next = levels->nodes.data[c].next_sibling;
+				if (levels->nodes.data[c].parent == cur) {
+					hierarchy_list_remove(levels, c);
+					hierarchy_levels_link(levels, c, cur, true);
+				}
+				c = next;
+			}
+		}
+	}
+
+	// Stops tracking e. Its children become roots until a node with their recorded parent shows up.
+	inline void hierarchy_levels_untrack(HierarchyLevels* levels, Entity e) {
+		if (!hierarchy_node_tracked(levels, e)) return;
+		u32 index = entity_index(e);
+		if (levels->nodes.data[index].depth > 0) store_mark_changed(&levels->world->transforms, e);
+		hierarchy_level_place(levels, index, 0);
+		if (levels->nodes.data[index].parent != INVALID_ENTITY) hierarchy_list_remove(levels, index);
+		levels->nodes.data[index].entity = INVALID_ENTITY;
+		levels->nodes.data[index].parent = INVALID_ENTITY;
+
+		for (u32 c = levels->nodes.data[index].first_child; c != INVALID_INDEX; c = levels->nodes.data[c].next_sibling) {
+			if (levels->nodes.data[c].parent != e) continue;
+			hierarchy_levels_move(levels, c, 0);
+			store_mark_changed(&levels->world->transforms, levels->nodes.data[c].entity);
+		}
+	}
+
+	inline void hierarchy_levels_reparent(HierarchyLevels* levels, Entity e) {
+		HierarchyNode* hn = store_get(&levels->world->hierarchy, e);
+		if (!hn) return;
+		if (!hierarchy_node_tracked(levels, e)) {
+			hierarchy_levels_track(levels, e);
+			return;
+		}
+		u32 index = entity_index(e);
+		if (levels->nodes.data[index].parent == hn->parent) return;
+		if (levels->nodes.data[index].parent != INVALID_ENTITY) hierarchy_list_remove(levels, index);
+		hierarchy_levels_link(levels, index, hn->parent, true);
+	}
+
+	// Levels keep their storage for the nodes that come back
+	inline void hierarchy_levels_reset(HierarchyLevels* levels) {
+		for (usize d = 0; d < levels->by_depth.count; d++) arr::array_clear(&levels->by_depth.data[d]);
+		arr::array_clear(&levels->nodes);
+	}
+
+	// Applies the hierarchy changes recorded since the last call and re-resolves transform indices
+	// if the transforms store moved entries. Nodes whose parent link appeared, changed or vanished
+	// are marked changed in World::transforms. Batches of at least an eighth of the hierarchy (scene
+	// loads and unloads) rebuild from scratch instead, which marks every linked node.
+	inline void hierarchy_levels_update(HierarchyLevels* levels) {
+		World* world = levels->world;
+		Store<HierarchyNode>* hierarchy = &world->hierarchy;
+		Store<Transform>* transforms = &world->transforms;
+
+		if (!levels->built || levels->pending.count * 8 >= hierarchy->data.count) {
+			// A node that left the hierarchy, and the children it left behind, still need their local matrix back
+			for (usize i = 0; i < levels->pending.count; i++) {
+				const HierarchyEvent& ev = levels->pending.data[i];
+				if (ev.event != STORE_EVENT_REMOVE || !hierarchy_node_tracked(levels, ev.entity)) continue;
+				store_mark_changed(transforms, ev.entity);
+				for (u32 c = levels->nodes.data[entity_index(ev.entity)].first_child; c != INVALID_INDEX; c = levels->nodes.data[c].next_sibling) {
+					if (levels->nodes.data[c].parent == ev.entity) store_mark_changed(transforms, levels->nodes.data[c].entity);
+				}
+			}
+			hierarchy_levels_reset(levels);
+			for (usize i = 0; i < hierarchy->entities.count; i++) hierarchy_levels_track(levels, hierarchy->entities.data[i]);
+		} else {
+			for (usize i = 0; i < levels->pending.count; i++) {
+				const HierarchyEvent& ev = levels->pending.data[i];
+				switch (ev.event) {
+					case STORE_EVENT_ADD:    hierarchy_levels_track(levels, ev.entity); break;
+					case STORE_EVENT_REMOVE: hierarchy_levels_untrack(levels, ev.entity); break;
+					case STORE_EVENT_SET:    hierarchy_levels_reparent(levels, ev.entity); break;
+					case STORE_EVENT_CLEAR:  hierarchy_levels_reset(levels); break;
+				}
+			}
+		}
+		arr::array_clear(&levels->pending);
+		levels->built = true;
+
+		// Dense indices moved: re-resolve every link. One whose child or parent transform appeared or
+		// went away changes what the child's world matrix is made of.
+		if (levels->transforms_version != transforms->version) {
+			for (usize d = 0; d < levels->by_depth.count; d++) {
+				arr::Array<HierarchyLink>* level = &levels->by_depth.data[d];
+				for (usize i = 0; i < level->count; i++) {
+					HierarchyLink& link = level->data[i];
+					bool was_resolved = hierarchy_link_resolved(link);
+					link.transform = hierarchy_transform_index(transforms, link.child);
+					link.parent_transform = hierarchy_transform_index(transforms, link.parent);
+					if (hierarchy_link_resolved(link) != was_resolved && link.transform != INVALID_INDEX) store_mark_changed_at(transforms, link.transform);
+				}
+			}
+			levels->transforms_version = transforms->version;
+		}
+	}
+
+	inline u32 hierarchy_level_count(const HierarchyLevels* levels) {
+		return (u32)levels->by_depth.count;
+	}
+
+	// Marks every descendant of a changed transform as changed. Levels run top-down so a change
+	// reaches the bottom of the tree in one pass.
+	inline void hierarchy_mark_descendants(const HierarchyLevels* levels, Store<Transform>* transforms) {
+		for (usize d = 0; d < levels->by_depth.count; d++) {
+			const arr::Array<HierarchyLink>& level = levels->by_depth.data[d];
+			for (usize i = 0; i < level.count; i++) {
+				const HierarchyLink& link = level.data[i];
+				if (!hierarchy_link_resolved(link)) continue;
+				if (bits::test(transforms->changed.data, link.parent_transform)) {
+					store_mark_changed_at(transforms, link.transform);
+				}
+			}
+		}
+	}
+
+	struct HierarchyPropagateJob {
+		const HierarchyLink* links;
+		Store<Transform>*    transforms;
+	};
+
+	inline void hierarchy_propagate_job(void* user, u32 begin, u32 end) {
+		HierarchyPropagateJob* job = (HierarchyPropagateJob*)user;
+		Transform* data = job->transforms->data.data;
+		const u64* changed = job->transforms->changed.data;
+		for (u32 i = begin; i < end; i++) {
+			const HierarchyLink& link = job->links[i];
+			if (!hierarchy_link_resolved(link) || !bits::test(changed, link.transform)) continue;
+			data[link.transform].local_to_world = data[link.parent_transform].local_to_world * data[link.transform].local_to_world;
+		}
+	}
+
+	// Composes parent matrices into changed children, one level at a time. Expects local matrices
+	// for changed entries to be up to date and descendants already marked.
+	inline void hierarchy_propagate(const HierarchyLevels* levels, Store<Transform>* transforms) {
+		for (usize d = 0; d < levels->by_depth.count; d++) {
+			const arr::Array<HierarchyLink>& level = levels->by_depth.data[d];
+			HierarchyPropagateJob job = { level.data, transforms };
+			jobs::parallel_for((u32)level.count, 256, hierarchy_propagate_job, &job);
+		}
+	}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/jobs.hpp"
+#include "ecs.hpp"
+
+// Systems declare the component types they read and write as component_mask<...>() bits.
+// scheduler_build orders them into waves: a system lands in the wave after the last earlier
+// system it conflicts with (write/write or read/write overlap). Systems in one wave run in parallel.
+
+namespace ecs {
+
+	struct World;
+
+	constexpr u32 MAX_SYSTEMS = 32;
+
+	using SystemFn = void (*)(World* world, void* user);
+
+	struct System {
+		const char* name;
+		SystemFn    fn;
+		void*       user;
+		u64         reads;
+		u64         writes;
+		u32         wave;
+		World*      world; // set for the duration of scheduler_run
+	};
+
+	struct Scheduler {
+		System systems[MAX_SYSTEMS];
+		u32    count;
+		u32    wave_count;
+	};
+
+	inline bool system_conflicts(const System& a, const System& b) {
+		return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+	}
+
+	// Registration order is the tie-breaker: a later system never runs before an earlier one it conflicts with.
+	inline bool scheduler_add(Scheduler* scheduler, const char* name, SystemFn fn, void* user, u64 reads, u64 writes) {
+		if (scheduler->count >= MAX_SYSTEMS) return false;
+		System& s = scheduler->systems[scheduler->count++];
+		s = {};
+		s.name = name;
+		s.fn = fn;
+		s.user = user;
+		s.reads = reads;
+		s.writes = writes;
+		return true;
+	}
+
+	inline void scheduler_build(Scheduler* scheduler) {
+		scheduler->wave_count = 0;
+		for (u32 i = 0; i < scheduler->count; i++) {
+			System& s = scheduler->systems[i];
+			s.wave = 0;
+			for (u32 j = 0; j < i; j++) {
+				const System& prev = scheduler->systems[j];
+				if (system_conflicts(s, prev) && prev.wave + 1 > s.wave) s.wave = prev.wave + 1;
+			}
+			if (s.wave + 1 > scheduler->wave_count) scheduler->wave_count = s.wave + 1;
+		}
+	}
+
+	inline void scheduler_run_job(void* user, u32, u32) {
+		System* s = (System*)user;
+		s->fn(s->world, s->user);
+	}
+
+	inline void scheduler_run(Scheduler* scheduler, World* world) {
+		for (u32 wave = 0; wave < scheduler->wave_count; wave++) {
+			jobs::Group group = {};
+			System* inline_system = nullptr;
+
+			for (u32 i = 0; i < scheduler->count; i++) {
+				System* s = &scheduler->systems[i];
+				if (s->wave != wave) continue;
+				s->world = world;
+				// Keep the first system of the wave for the calling thread, hand the rest to workers
+				if (!inline_system) { inline_system = s; continue; }
+				jobs::submit(&group, scheduler_run_job, s, 0, 1);
+			}
+
+			if (inline_system) scheduler_run_job(inline_system, 0, 1);
+			jobs::wait(&group);
+		}
+	}
+
+}
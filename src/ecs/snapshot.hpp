@@ -0,0 +1,264 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/array.hpp"
+#include "../core/bits.hpp"
+#include "../core/bvh.hpp"
+#include "world.hpp"
+#include "sort.hpp"
+#include "view.hpp"
+
+// Double-buffered copy of what the renderer reads from the World: one (asset, model matrix) entry
+// per mesh instance, grouped by asset. Simulation captures into the back buffer at the end of its
+// frame while the renderer draws the front one, so the two never touch the same memory. Capture
+// also keeps World::transforms in the same dense order as the (asset-sorted) mesh instances.
+//
+// Capturing is copy-on-write by page of SNAPSHOT_PAGE_SIZE entries: only pages holding a changed
+// transform are re-copied, plus the pages the other buffer copied since this one was last written.
+// Any change to the store layouts (add, remove, sort) or to the hidden tag re-copies everything.
+//
+// Each buffer also keeps world-space bounds per entry and a BVH over them, built from the asset
+// bounds given to render_snapshots_set_asset_bounds. Re-copied entries are moved in that buffer's
+// tree, so culling and picking read a tree that always matches the buffer's models.
+//
+// Each capture is numbered and records the pages it wrote (copied_pages). Two consecutive captures
+// differ only inside the later one's copied pages, so a consumer mirroring the front buffer (e.g.
+// GPU-resident instance data) can re-send just those pages when it sees capture n + 1 after n.
+
+namespace ecs {
+
+	constexpr u32 SNAPSHOT_PAGE_BITS = 6;
+	constexpr u32 SNAPSHOT_PAGE_SIZE = 1u << SNAPSHOT_PAGE_BITS;
+	constexpr f32 SNAPSHOT_BVH_MARGIN = 0.1f; // fat-box margin, world units
+
+	struct RenderSnapshot {
+		arr::Array<u32>      asset_ids;   // per entry, INVALID_INDEX for hidden instances or ones without a transform
+		arr::Array<mat3x4>   models;      // per entry
+		arr::Array<Entity>   entities;    // per entry
+		arr::Array<AABB>     bounds;      // per entry, world space; valid where proxies isn't NULL_NODE
+		arr::Array<u32>      proxies;     // per entry, leaf in tree or bvh::NULL_NODE when not drawn
+		bvh::Tree            tree;        // leaf user value is the entry index
+		arr::Array<KeyRange> groups;      // entry ranges per asset id, ascending
+		arr::Array<u64>      stale_pages; // pages the other buffer re-copied since this one was written
+		arr::Array<u64>      copied_pages; // pages written by the capture numbered `capture`
+		u32                  capture;     // RenderSnapshots::capture_count when this buffer was last written
+		u32                  layout;      // RenderSnapshots::layout this buffer was copied against
+		bool                 full_copy;   // the last capture re-copied every entry
+		bool                 valid;
+	};
+
+	struct RenderSnapshots {
+		RenderSnapshot  buffers[2];
+		u32             front;
+		StoreGroups     mesh_groups;     // keeps World::mesh_instances sorted by asset id; its scratch also serves store_follow
+		arr::Array<u32> transform_index; // per mesh dense index, dense index in World::transforms (INVALID_INDEX when hidden)
+		arr::Array<u64> dirty_pages;     // scratch
+		u32             mesh_version;
+		u32             transforms_version;
+		u32             hidden_version;
+		u32             layout;          // bumped whenever transform_index is rebuilt
+		bool            layout_built;
+		u32             captured_pages;  // pages copied by the last capture
+		u32             capture_count;   // captures so far
+		arr::Array<AABB> asset_bounds;   // local bounds per asset id
+	};
+
+	inline void render_snapshot_destroy(RenderSnapshot* snapshot) {
+		arr::array_destroy(&snapshot->asset_ids);
+		arr::array_destroy(&snapshot->models);
+		arr::array_destroy(&snapshot->entities);
+		arr::array_destroy(&snapshot->bounds);
+		arr::array_destroy(&snapshot->proxies);
+		bvh::destroy(&snapshot->tree);
+		arr::array_destroy(&snapshot->groups);
+		arr::array_destroy(&snapshot->stale_pages);
+		arr::array_destroy(&snapshot->copied_pages);
+		*snapshot = {};
+	}
+
+	inline void render_snapshots_destroy(RenderSnapshots* snapshots) {
+		render_snapshot_destroy(&snapshots->buffers[0]);
+		render_snapshot_destroy(&snapshots->buffers[1]);
+		store_groups_destroy(&snapshots->mesh_groups);
+		arr::array_destroy(&snapshots->transform_index);
+		arr::array_destroy(&snapshots->dirty_pages);
+		arr::array_destroy(&snapshots->asset_bounds);
+		*snapshots = {};
+	}
+
+	inline const RenderSnapshot* render_snapshot_front(const RenderSnapshots* snapshots) {
+		return &snapshots->buffers[snapshots->front];
+	}
+
+	// Publishes the last capture. Call once simulation has finished writing the back buffer.
+	inline void render_snapshots_swap(RenderSnapshots* snapshots) {
+		snapshots->front ^= 1;
+	}
+
+	// Drops both buffers, e.g. when the assets their ids refer to are unloaded.
+	inline void render_snapshots_invalidate(RenderSnapshots* snapshots) {
+		for (u32 b = 0; b < 2; b++) {
+			RenderSnapshot* snapshot = &snapshots->buffers[b];
+			arr::array_clear(&snapshot->asset_ids);
+			arr::array_clear(&snapshot->models);
+			arr::array_clear(&snapshot->entities);
+			arr::array_clear(&snapshot->bounds);
+			arr::array_clear(&snapshot->proxies);
+			bvh::clear(&snapshot->tree);
+			arr::array_clear(&snapshot->groups);
+			snapshot->valid = false;
+		}
+		snapshots->layout_built = false;
+	}
+
+	// Local bounds per asset id. Entries whose asset has no bounds are not drawn. Re-copies everything.
+	inline void render_snapshots_set_asset_bounds(RenderSnapshots* snapshots, const AABB* bounds, u32 count) {
+		arr::array_resize(&snapshots->asset_bounds, count);
+		memory::copy(snapshots->asset_bounds.data, bounds, count * sizeof(AABB));
+		snapshots->layout_built = false;
+	}
+
+	inline u32 render_snapshot_mesh_key(const MeshInstance& mi) {
+		return mi.asset_id;
+	}
+
+	inline void render_snapshot_copy_range(RenderSnapshot* snapshot, const RenderSnapshots* snapshots, const World* world, u32 begin, u32 end) {
+		const u32* transform_index = snapshots->transform_index.data;
+		const Transform* transforms = world->transforms.data.data;
+		const AABB* asset_bounds = snapshots->asset_bounds.data;
+		for (u32 i = begin; i < end; i++) {
+			u32 ti = transform_index[i];
+			if (ti == INVALID_INDEX) continue;
+			snapshot->models.data[i] = transforms[ti].local_to_world;
+
+			u32 proxy = snapshot->proxies.data[i];
+			if (proxy == bvh::NULL_NODE) continue;
+			snapshot->bounds.data[i] = aabb_transform(asset_bounds[snapshot->asset_ids.data[i]], snapshot->models.data[i]);
+			bvh::move(&snapshot->tree, proxy, snapshot->bounds.data[i]);
+		}
+	}
+
+	// Fills the back buffer from world. Must run after the frame's transforms are final and before
+	// their changed bits are cleared, with nothing else writing the World.
+	inline void render_snapshots_capture(RenderSnapshots* snapshots, World* world) {
+		store_groups_update(&snapshots->mesh_groups, &world->mesh_instances, render_snapshot_mesh_key);
+
+		Store<MeshInstance>* meshes = &world->mesh_instances;
+		Store<Transform>* transforms = &world->transforms;
+
+		// Transforms follow the mesh order, so transform_index is ascending and every pass below
+		// streams both stores instead of jumping through the sparse index. Only layout changes move them.
+		if (!snapshots->layout_built
+			|| snapshots->mesh_version != meshes->version
+			|| snapshots->transforms_version != transforms->version) {
+			store_follow(transforms, meshes, &snapshots->mesh_groups.scratch);
+		}
+		u32 count = (u32)meshes->data.count;
+		u32 page_count = (count + SNAPSHOT_PAGE_SIZE - 1) >> SNAPSHOT_PAGE_BITS;
+		u32 page_words = bits::word_count(page_count);
+
+		if (!snapshots->layout_built
+			|| snapshots->mesh_version != meshes->version
+			|| snapshots->transforms_version != transforms->version
+			|| snapshots->hidden_version != world->hidden.version) {
+			// After store_follow the join is one span per run of meshes with a transform
+			arr::array_resize(&snapshots->transform_index, count);
+			memory::set(snapshots->transform_index.data, 0xFF, count * sizeof(u32));
+			u32* transform_index = snapshots->transform_index.data;
+			view_each_span(view(meshes, transforms), [&](const Entity*, MeshInstance* mi, Transform* t, u32 n) {
+				u32 mesh_begin = (u32)(mi - meshes->data.data);
+				u32 transform_begin = (u32)(t - transforms->data.data);
+				for (u32 k = 0; k < n; k++) transform_index[mesh_begin + k] = transform_begin + k;
+			});
+
+			// Hidden entities are usually few, so they are unjoined by walking the tag's words
+			tag_each(&world->hidden, &world->pool, [&](Entity e) {
+				u32 mi = sparse_get(&meshes->sparse, entity_index(e));
+				if (mi != INVALID_INDEX && meshes->entities.data[mi] == e) transform_index[mi] = INVALID_INDEX;
+			});
+			snapshots->mesh_version = meshes->version;
+			snapshots->transforms_version = transforms->version;
+			snapshots->hidden_version = world->hidden.version;
+			snapshots->layout++;
+			snapshots->layout_built = true;
+		}
+
+		RenderSnapshot* back = &snapshots->buffers[snapshots->front ^ 1];
+		RenderSnapshot* other = &snapshots->buffers[snapshots->front];
+		snapshots->captured_pages = 0;
+		back->capture = ++snapshots->capture_count;
+		arr::array_resize(&back->copied_pages, page_words);
+
+		// Pages holding a transform changed this frame
+		arr::array_resize(&snapshots->dirty_pages, page_words);
+		u64* dirty = snapshots->dirty_pages.data;
+		memory::set(dirty, 0, page_words * sizeof(u64));
+		if (transforms->changed_count > 0) {
+			for (u32 i = 0; i < count; i++) {
+				u32 ti = snapshots->transform_index.data[i];
+				if (ti != INVALID_INDEX && bits::test(transforms->changed.data, ti)) bits::set(dirty, i >> SNAPSHOT_PAGE_BITS);
+			}
+		}
+
+		if (!back->valid || back->layout != snapshots->layout) {
+			// Layout changed since this buffer was written: copy everything
+			arr::array_resize(&back->asset_ids, count);
+			arr::array_resize(&back->models, count);
+			arr::array_resize(&back->entities, count);
+			arr::array_resize(&back->bounds, count);
+			arr::array_resize(&back->proxies, count);
+			for (u32 i = 0; i < count; i++) {
+				back->asset_ids.data[i] = snapshots->transform_index.data[i] != INVALID_INDEX ? meshes->data.data[i].asset_id : INVALID_INDEX;
+			}
+			memory::copy(back->entities.data, meshes->entities.data, count * sizeof(Entity));
+			memory::set(back->proxies.data, 0xFF, count * sizeof(u32));
+			render_snapshot_copy_range(back, snapshots, world, 0, count);
+
+			// Rebuild the tree from scratch
+			bvh::clear(&back->tree);
+			back->tree.margin = SNAPSHOT_BVH_MARGIN;
+			u32 asset_count = (u32)snapshots->asset_bounds.count;
+			for (u32 i = 0; i < count; i++) {
+				u32 asset_id = back->asset_ids.data[i];
+				if (asset_id >= asset_count) continue;
+				back->bounds.data[i] = aabb_transform(snapshots->asset_bounds.data[asset_id], back->models.data[i]);
+				back->proxies.data[i] = bvh::insert(&back->tree, back->bounds.data[i], i);
+			}
+
+			arr::array_resize(&back->groups, snapshots->mesh_groups.ranges.count);
+			memory::copy(back->groups.data, snapshots->mesh_groups.ranges.data, back->groups.count * sizeof(KeyRange));
+
+			arr::array_resize(&back->stale_pages, page_words);
+			memory::set(back->stale_pages.data, 0, page_words * sizeof(u64));
+			back->layout = snapshots->layout;
+			back->valid = true;
+			back->full_copy = true;
+			memory::set(back->copied_pages.data, 0xFF, page_words * sizeof(u64));
+			snapshots->captured_pages = page_count;
+		} else {
+			// Same layout: re-copy the pages changed this frame and the ones the other buffer took last frame
+			back->full_copy = false;
+			for (u32 w = 0; w < page_words; w++) {
+				u64 pages = dirty[w] | back->stale_pages.data[w];
+				back->stale_pages.data[w] = 0;
+				back->copied_pages.data[w] = pages;
+				while (pages) {
+					u32 page = w * 64 + bits::ctz64(pages);
+					pages &= pages - 1;
+					u32 begin = page << SNAPSHOT_PAGE_BITS;
+					if (begin >= count) break;
+					u32 end = begin + SNAPSHOT_PAGE_SIZE < count ? begin + SNAPSHOT_PAGE_SIZE : count;
+					render_snapshot_copy_range(back, snapshots, world, begin, end);
+					snapshots->captured_pages++;
+				}
+			}
+		}
+
+		// Whatever changed this frame is now stale in the other buffer. A buffer built against an
+		// older layout is re-copied in full anyway.
+		if (other->valid && other->layout == snapshots->layout) {
+			for (u32 w = 0; w < page_words; w++) other->stale_pages.data[w] |= dirty[w];
+		}
+	}
+
+}
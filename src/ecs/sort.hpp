@@ -0,0 +1,205 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/array.hpp"
+#include "../core/bits.hpp"
+#include "ecs.hpp"
+
+// Key-ordered stores. store_sort reorders a store's dense arrays by a u32 key (stable LSD radix
+// sort) and fixes the sparse index and changed bits in the same pass. StoreGroups keeps a store
+// sorted across frames and exposes each key as one contiguous dense range. store_follow lines one
+// store up behind another so a join over the two reads both front to back.
+
+namespace ecs {
+
+	struct SortScratch {
+		arr::Array<u32>  keys;
+		arr::Array<u32>  order;
+		arr::Array<u32>  temp;
+		arr::Array<byte> data;
+		arr::Array<u64>  changed;
+	};
+
+	inline void sort_scratch_destroy(SortScratch* scratch) {
+		arr::array_destroy(&scratch->keys);
+		arr::array_destroy(&scratch->order);
+		arr::array_destroy(&scratch->temp);
+		arr::array_destroy(&scratch->data);
+		arr::array_destroy(&scratch->changed);
+	}
+
+	// Moves dense entry order[i] to i for every i, with its entity and changed bit, and bumps the version.
+	template<typename T>
+	void store_permute(Store<T>* store, const u32* order, SortScratch* scratch) {
+		u32 count = (u32)store->data.count;
+		arr::array_resize(&scratch->temp, count);
+		u32* temp = scratch->temp.data;
+
+		arr::array_resize(&scratch->data, (usize)count * sizeof(T));
+		T* data = (T*)scratch->data.data;
+		for (u32 i = 0; i < count; i++) {
+			memory::copy(&data[i], &store->data.data[order[i]], sizeof(T));
+			temp[i] = store->entities.data[order[i]];
+		}
+		memory::copy(store->data.data, data, (usize)count * sizeof(T));
+		memory::copy(store->entities.data, temp, (usize)count * sizeof(Entity));
+
+		if (store->changed_count > 0) {
+			arr::array_resize(&scratch->changed, store->changed.count);
+			memory::set(scratch->changed.data, 0, store->changed.count * sizeof(u64));
+			for (u32 i = 0; i < count; i++) {
+				if (bits::test(store->changed.data, order[i])) bits::set(scratch->changed.data, i);
+			}
+			memory::copy(store->changed.data, scratch->changed.data, store->changed.count * sizeof(u64));
+		}
+
+		for (u32 i = 0; i < count; i++) {
+			sparse_set(&store->sparse, entity_index(store->entities.data[i]), i);
+		}
+
+		store->version++;
+	}
+
+	// Sorts dense entries by key_fn(const T&) -> u32, keeping insertion order among equal keys.
+	// Returns false without touching the store when it is already in order. Components are moved
+	// with memory::copy like everywhere else in Store.
+	template<typename T, typename KeyFn>
+	bool store_sort(Store<T>* store, KeyFn key_fn, SortScratch* scratch) {
+		u32 count = (u32)store->data.count;
+		if (count < 2) return false;
+
+		arr::array_resize(&scratch->keys, count);
+		u32* keys = scratch->keys.data;
+		bool sorted = true;
+		for (u32 i = 0; i < count; i++) {
+			keys[i] = key_fn(store->data.data[i]);
+			if (i > 0 && keys[i] < keys[i - 1]) sorted = false;
+		}
+		if (sorted) return false;
+
+		arr::array_resize(&scratch->order, count);
+		arr::array_resize(&scratch->temp, count);
+		u32* order = scratch->order.data;
+		u32* temp = scratch->temp.data;
+		for (u32 i = 0; i < count; i++) order[i] = i;
+
+		// 8 bits per pass; a pass is skipped when every key shares that byte
+		for (u32 shift = 0; shift < 32; shift += 8) {
+			u32 histogram[256] = {};
+			for (u32 i = 0; i < count; i++) histogram[(keys[i] >> shift) & 0xFF]++;
+			if (histogram[(keys[0] >> shift) & 0xFF] == count) continue;
+
+			u32 running = 0;
+			for (u32 b = 0; b < 256; b++) {
+				u32 n = histogram[b];
+				histogram[b] = running;
+				running += n;
+			}
+			for (u32 i = 0; i < count; i++) {
+				u32 src = order[i];
+				temp[histogram[(keys[src] >> shift) & 0xFF]++] = src;
+			}
+			u32* swap = order; order = temp; temp = swap;
+		}
+
+		// The passes may have left the result in either buffer; permute reuses temp
+		if (order != scratch->order.data) memory::copy(scratch->order.data, order, count * sizeof(u32));
+		store_permute(store, scratch->order.data, scratch);
+		return true;
+	}
+
+	// Reorders store so the entities it shares with leader come first, in leader's dense order, and
+	// the rest follow in their current order. Returns false without touching the store when it is
+	// already in that order.
+	template<typename T, typename U>
+	bool store_follow(Store<T>* store, const Store<U>* leader, SortScratch* scratch) {
+		u32 count = (u32)store->data.count;
+		if (count < 2) return false;
+
+		arr::array_resize(&scratch->order, count);
+		arr::array_resize(&scratch->keys, count);
+		u32* order = scratch->order.data;
+		u32* placed = scratch->keys.data; // 1 once an entry has its new position
+		memory::set(placed, 0, count * sizeof(u32));
+
+		u32 next = 0;
+		bool in_order = true;
+		for (usize i = 0; i < leader->entities.count; i++) {
+			Entity e = leader->entities.data[i];
+			u32 di = sparse_get(&store->sparse, entity_index(e));
+			if (di == INVALID_INDEX || store->entities.data[di] != e) continue;
+			if (di != next) in_order = false;
+			order[next++] = di;
+			placed[di] = 1;
+		}
+		for (u32 i = 0; i < count; i++) {
+			if (placed[i]) continue;
+			if (i != next) in_order = false;
+			order[next++] = i;
+		}
+		if (in_order) return false;
+
+		store_permute(store, order, scratch);
+		return true;
+	}
+
+	struct KeyRange {
+		u32 key;
+		u32 begin; // dense index
+		u32 count;
+	};
+
+	// Keys are read from the components, so a component whose key is edited in place needs
+	// store_groups_invalidate (or a remove/add) before the next update.
+	struct StoreGroups {
+		arr::Array<KeyRange> ranges; // ascending by key
+		SortScratch          scratch;
+		u32                  version;
+		bool                 built;
+	};
+
+	inline void store_groups_destroy(StoreGroups* groups) {
+		arr::array_destroy(&groups->ranges);
+		sort_scratch_destroy(&groups->scratch);
+		*groups = {};
+	}
+
+	inline void store_groups_invalidate(StoreGroups* groups) {
+		groups->built = false;
+	}
+
+	// Re-sorts and rebuilds ranges only when the store's dense order changed since the last update.
+	template<typename T, typename KeyFn>
+	void store_groups_update(StoreGroups* groups, Store<T>* store, KeyFn key_fn) {
+		if (groups->built && groups->version == store->version) return;
+
+		store_sort(store, key_fn, &groups->scratch);
+
+		arr::array_clear(&groups->ranges);
+		u32 count = (u32)store->data.count;
+		for (u32 i = 0; i < count; i++) {
+			u32 key = key_fn(store->data.data[i]);
+			if (groups->ranges.count > 0 && groups->ranges.data[groups->ranges.count - 1].key == key) {
+				groups->ranges.data[groups->ranges.count - 1].count++;
+			} else {
+				arr::array_push(&groups->ranges, KeyRange{ key, i, 1 });
+			}
+		}
+
+		groups->version = store->version;
+		groups->built = true;
+	}
+
+	inline const KeyRange* store_groups_find(const StoreGroups* groups, u32 key) {
+		usize lo = 0;
+		usize hi = groups->ranges.count;
+		while (lo < hi) {
+			usize mid = (lo + hi) / 2;
+			if (groups->ranges.data[mid].key < key) lo = mid + 1;
+			else hi = mid;
+		}
+		if (lo < groups->ranges.count && groups->ranges.data[lo].key == key) return &groups->ranges.data[lo];
+		return nullptr;
+	}
+
+}
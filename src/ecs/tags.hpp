@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/array.hpp"
+#include "../core/bits.hpp"
+#include "ecs.hpp"
+
+// Zero-size marker components ("hidden", "static", "selected") kept as one bit per entity index:
+// no dense data, no entity array and no sparse pages. tag_each walks the set a 64-bit word at a
+// time, so passes that only care about the tagged few skip everyone else a word at once.
+//
+// A tag bit is keyed by entity index only, so tags must be cleared when an entity is destroyed
+// (world_destroy_entity does this for the World's tags).
+
+namespace ecs {
+
+	struct TagStore {
+		arr::Array<u64> words; // grows to the highest tagged index
+		u32             count;
+		u32             version; // bumped on every change
+	};
+
+	inline void tag_destroy(TagStore* tag) {
+		arr::array_destroy(&tag->words);
+		*tag = {};
+	}
+
+	inline void tag_reserve_words(TagStore* tag, usize word_count) {
+		if (tag->words.count >= word_count) return;
+		usize old_count = tag->words.count;
+		arr::array_resize(&tag->words, word_count);
+		memory::set(tag->words.data + old_count, 0, (word_count - old_count) * sizeof(u64));
+	}
+
+	inline bool tag_has(const TagStore* tag, Entity e) {
+		u32 index = entity_index(e);
+		return (index >> 6) < tag->words.count && bits::test(tag->words.data, index);
+	}
+
+	inline void tag_add(TagStore* tag, Entity e) {
+		u32 index = entity_index(e);
+		tag_reserve_words(tag, (index >> 6) + 1);
+		if (bits::test(tag->words.data, index)) return;
+		bits::set(tag->words.data, index);
+		tag->count++;
+		tag->version++;
+	}
+
+	inline void tag_remove(TagStore* tag, Entity e) {
+		if (!tag_has(tag, e)) return;
+		bits::clear(tag->words.data, entity_index(e));
+		tag->count--;
+		tag->version++;
+	}
+
+	inline void tag_set(TagStore* tag, Entity e, bool on) {
+		if (on) tag_add(tag, e);
+		else tag_remove(tag, e);
+	}
+
+	inline void tag_clear(TagStore* tag) {
+		if (tag->count == 0) return;
+		memory::set(tag->words.data, 0, tag->words.count * sizeof(u64));
+		tag->count = 0;
+		tag->version++;
+	}
+
+	// Calls fn(Entity) for every live tagged entity, intersecting with the pool's alive bits a word at a time.
+	template<typename Fn>
+	void tag_each(const TagStore* tag, const EntityPool* pool, Fn fn) {
+		usize n = tag->words.count < pool->alive.count ? tag->words.count : pool->alive.count;
+		for (usize w = 0; w < n; w++) {
+			u64 word = tag->words.data[w] & pool->alive.data[w];
+			while (word) {
+				u32 index = (u32)w * 64 + bits::ctz64(word);
+				word &= word - 1;
+				fn(entity_make(index, pool->generations.data[index]));
+			}
+		}
+	}
+
+}
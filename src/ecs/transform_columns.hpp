@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "../core/math.hpp"
+#include "components.hpp"
+
+#include <stddef.h>
+
+// Structure-of-arrays view of Transform records for the local transform pass. Everything else
+// reads whole records, so the TRS inputs stay in Transform and are moved into a TrsBlock's aligned
+// columns a changed word at a time, four records per 4x4 transpose. mat3x4_from_trs_block composes
+// 8 at a time from the columns and transposes each matrix row straight back into its record.
+
+namespace ecs {
+
+	// The gather loads 4 floats at position, rotation and rotation.w, all inside the record
+	static_assert(offsetof(Transform, rotation) == 3 * sizeof(f32), "Transform TRS must be packed");
+	static_assert(offsetof(Transform, scale) == 7 * sizeof(f32), "Transform TRS must be packed");
+	static_assert(offsetof(Transform, local_to_world) == 10 * sizeof(f32), "Transform TRS must be packed");
+
+	// Copies the TRS of data[dense[0..count)] into block's columns, count <= TRS_BLOCK.
+	inline void transform_columns_gather(TrsBlock* block, const Transform* data, const u32* dense, u32 count) {
+		u32 i = 0;
+#if MATH_SSE
+		for (; i + 4 <= count; i += 4) {
+			const Transform& a = data[dense[i]];
+			const Transform& b = data[dense[i + 1]];
+			const Transform& c = data[dense[i + 2]];
+			const Transform& d = data[dense[i + 3]];
+
+			// position.xyz, rotation.x
+			__m128 r0 = _mm_loadu_ps(&a.position.x), r1 = _mm_loadu_ps(&b.position.x);
+			__m128 r2 = _mm_loadu_ps(&c.position.x), r3 = _mm_loadu_ps(&d.position.x);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(block->t[0] + i, r0);
+			_mm_store_ps(block->t[1] + i, r1);
+			_mm_store_ps(block->t[2] + i, r2);
+
+			r0 = _mm_loadu_ps(&a.rotation.x); r1 = _mm_loadu_ps(&b.rotation.x);
+			r2 = _mm_loadu_ps(&c.rotation.x); r3 = _mm_loadu_ps(&d.rotation.x);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(block->r[0] + i, r0);
+			_mm_store_ps(block->r[1] + i, r1);
+			_mm_store_ps(block->r[2] + i, r2);
+			_mm_store_ps(block->r[3] + i, r3);
+
+			// rotation.w, scale.xyz
+			r0 = _mm_loadu_ps(&a.rotation.w); r1 = _mm_loadu_ps(&b.rotation.w);
+			r2 = _mm_loadu_ps(&c.rotation.w); r3 = _mm_loadu_ps(&d.rotation.w);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_store_ps(block->s[0] + i, r1);
+			_mm_store_ps(block->s[1] + i, r2);
+			_mm_store_ps(block->s[2] + i, r3);
+		}
+#endif
+		for (; i < count; i++) {
+			const Transform& t = data[dense[i]];
+			block->t[0][i] = t.position.x; block->t[1][i] = t.position.y; block->t[2][i] = t.position.z;
+			block->r[0][i] = t.rotation.x; block->r[1][i] = t.rotation.y; block->r[2][i] = t.rotation.z; block->r[3][i] = t.rotation.w;
+			block->s[0][i] = t.scale.x; block->s[1][i] = t.scale.y; block->s[2][i] = t.scale.z;
+		}
+	}
+
+	// local_to_world = mat3x4_from_trs(position, rotation, scale) for data[dense[0..count)].
+	inline void transform_compose(TrsBlock* block, Transform* data, const u32* dense, u32 count) {
+#if MATH_SSE
+		mat3x4* out[TRS_BLOCK];
+		for (u32 i = 0; i < count; i++) out[i] = &data[dense[i]].local_to_world;
+		transform_columns_gather(block, data, dense, count);
+		mat3x4_from_trs_block(block, count, out);
+#else
+		// Without SIMD the columns only add copies
+		(void)block;
+		for (u32 i = 0; i < count; i++) {
+			Transform& t = data[dense[i]];
+			t.local_to_world = mat3x4_from_trs(t.position, t.rotation, t.scale);
+		}
+#endif
+	}
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../core/types.hpp"
+#include "ecs.hpp"
+
+// Multi-store queries. A View<A, B, ...> iterates the entities present in every store, driven by
+// the store with the fewest entries: the driver's dense array is walked in order with no has-check,
+// and only the other stores are probed through their sparse index.
+
+namespace ecs {
+
+	template<u32... Is> struct Indices {};
+	template<u32 N, u32... Is> struct MakeIndices : MakeIndices<N - 1, N - 1, Is...> {};
+	template<u32... Is> struct MakeIndices<0, Is...> { using Type = Indices<Is...>; };
+
+	struct StoreRef {
+		const arr::Array<Entity>* entities;
+		const SparseIndex*        sparse;
+		void*                     data;
+	};
+
+	template<typename... Ts>
+	struct View {
+		StoreRef stores[sizeof...(Ts)];
+		u32      driver;
+	};
+
+	template<typename T>
+	StoreRef store_ref(Store<T>* store) {
+		return { &store->entities, &store->sparse, store->data.data };
+	}
+
+	template<typename... Ts>
+	View<Ts...> view(Store<Ts>*... stores) {
+		View<Ts...> v = { { store_ref(stores)... }, 0 };
+		for (u32 s = 1; s < sizeof...(Ts); s++) {
+			if (v.stores[s].entities->count < v.stores[v.driver].entities->count) v.driver = s;
+		}
+		return v;
+	}
+
+	template<typename... Ts>
+	usize view_size_hint(const View<Ts...>& v) {
+		return v.stores[v.driver].entities->count;
+	}
+
+	// Fills dense[] with e's dense index in every store, or returns false if a store lacks e.
+	template<typename... Ts>
+	bool view_resolve(const View<Ts...>& v, Entity e, u32 driver_index, u32* dense) {
+		for (u32 s = 0; s < sizeof...(Ts); s++) {
+			if (s == v.driver) { dense[s] = driver_index; continue; }
+			u32 di = sparse_get(v.stores[s].sparse, entity_index(e));
+			if (di == INVALID_INDEX || v.stores[s].entities->data[di] != e) return false;
+			dense[s] = di;
+		}
+		return true;
+	}
+
+	template<typename... Ts, u32... Is, typename Fn>
+	void view_invoke(const View<Ts...>& v, Entity e, const u32* dense, Indices<Is...>, Fn& fn) {
+		fn(e, ((Ts*)v.stores[Is].data)[dense[Is]]...);
+	}
+
+	template<typename... Ts, u32... Is, typename Fn>
+	void view_invoke_span(const View<Ts...>& v, const u32* dense, u32 count, Indices<Is...>, Fn& fn) {
+		fn(v.stores[v.driver].entities->data + dense[v.driver], ((Ts*)v.stores[Is].data + dense[Is])..., count);
+	}
+
+	// Calls fn(Entity, Ts&...) for joined entities within driver dense range [begin, end).
+	// Disjoint ranges touch disjoint driver entries, so they can be handed to different threads.
+	template<typename... Ts, typename Fn>
+	void view_each_range(const View<Ts...>& v, u32 begin, u32 end, Fn fn) {
+		const arr::Array<Entity>* driver = v.stores[v.driver].entities;
+		u32 dense[sizeof...(Ts)];
+		for (u32 i = begin; i < end; i++) {
+			Entity e = driver->data[i];
+			if (!view_resolve(v, e, i, dense)) continue;
+			view_invoke(v, e, dense, typename MakeIndices<sizeof...(Ts)>::Type{}, fn);
+		}
+	}
+
+	// Calls fn(Entity, Ts&...) for every entity present in all stores.
+	template<typename... Ts, typename Fn>
+	void view_each(const View<Ts...>& v, Fn fn) {
+		view_each_range(v, 0, (u32)v.stores[v.driver].entities->count, fn);
+	}
+
+	// Calls fn(const Entity*, Ts*..., count) for runs where every store's dense arrays line up,
+	// i.e. consecutive driver entries map to consecutive entries in all other stores. Stores kept
+	// in the same order (or single-store views) come out as one span each.
+	template<typename... Ts, typename Fn>
+	void view_each_span(const View<Ts...>& v, Fn fn) {
+		const arr::Array<Entity>* driver = v.stores[v.driver].entities;
+		u32 start[sizeof...(Ts)];
+		u32 next[sizeof...(Ts)];
+		u32 run = 0;
+
+		for (u32 i = 0; i < (u32)driver->count; i++) {
+			if (!view_resolve(v, driver->data[i], i, next)) {
+				if (run) view_invoke_span(v, start, run, typename MakeIndices<sizeof...(Ts)>::Type{}, fn);
+				run = 0;
+				continue;
+			}
+
+			bool contiguous = run > 0;
+			for (u32 s = 0; contiguous && s < sizeof...(Ts); s++) {
+				contiguous = next[s] == start[s] + run;
+			}
+
+			if (contiguous) {
+				run++;
+			} else {
+				if (run) view_invoke_span(v, start, run, typename MakeIndices<sizeof...(Ts)>::Type{}, fn);
+				for (u32 s = 0; s < sizeof...(Ts); s++) start[s] = next[s];
+				run = 1;
+			}
+		}
+
+		if (run) view_invoke_span(v, start, run, typename MakeIndices<sizeof...(Ts)>::Type{}, fn);
+	}
+
+}
@@ -2,6 +2,7 @@
 
 #include "ecs.hpp"
 #include "components.hpp"
+#include "tags.hpp"
 
 namespace ecs {
 
@@ -10,20 +11,137 @@ namespace ecs {
 		Store<Transform>        transforms;
 		Store<MeshInstance>     mesh_instances;
 		Store<HierarchyNode>    hierarchy;
+		TagStore                hidden;   // excluded from rendering
 	};
 
-	inline void world_init(World* world) {
-		pool_init(&world->pool);
-		store_init(&world->transforms);
-		store_init(&world->mesh_instances);
-		store_init(&world->hierarchy);
+	// capacity bounds the entity index range; sparse pages and pool arrays are only paid for as they fill.
+	inline void world_init(World* world, u32 capacity = DEFAULT_ENTITY_CAPACITY) {
+		pool_init(&world->pool, capacity);
+		store_init(&world->transforms, capacity);
+		store_init(&world->mesh_instances, capacity);
+		store_init(&world->hierarchy, capacity);
+		world->hidden = {};
 	}
 
 	inline void world_destroy(World* world) {
+		tag_destroy(&world->hidden);
 		store_destroy(&world->hierarchy);
 		store_destroy(&world->mesh_instances);
 		store_destroy(&world->transforms);
 		pool_destroy(&world->pool);
 	}
 
+	// Store lookup by component type, for code that only knows T (command buffers, generic helpers).
+	template<typename T> Store<T>* world_store(World* world);
+	template<> inline Store<Transform>*     world_store<Transform>(World* world)     { return &world->transforms; }
+	template<> inline Store<MeshInstance>*  world_store<MeshInstance>(World* world)  { return &world->mesh_instances; }
+	template<> inline Store<HierarchyNode>* world_store<HierarchyNode>(World* world) { return &world->hierarchy; }
+
+	// Empties every store and releases every entity.
+	inline void world_clear(World* world) {
+		store_clear(&world->hierarchy);
+		store_clear(&world->transforms);
+		store_clear(&world->mesh_instances);
+		tag_clear(&world->hidden);
+		pool_clear(&world->pool);
+	}
+
+	// Destroys a batch of entities with one compaction per store. When the batch covers every live
+	// entity the world is cleared outright instead.
+	inline void world_destroy_entities(World* world, const Entity* entities, u32 count) {
+		if (count == 0) return;
+
+		EntityPool* pool = &world->pool;
+		usize words = bits::word_count(pool->next_index);
+		u64* listed = (u64*)memory::malloc(words * sizeof(u64));
+		memory::set(listed, 0, words * sizeof(u64));
+		u32 live = 0;
+		for (u32 i = 0; i < count; i++) {
+			if (!pool_alive(pool, entities[i]) || bits::test(listed, entity_index(entities[i]))) continue;
+			bits::set(listed, entity_index(entities[i]));
+			live++;
+		}
+		memory::free(listed);
+
+		if (live == pool->count) {
+			world_clear(world);
+			return;
+		}
+
+		store_remove_n(&world->hierarchy, entities, count);
+		store_remove_n(&world->transforms, entities, count);
+		store_remove_n(&world->mesh_instances, entities, count);
+		for (u32 i = 0; i < count; i++) {
+			if (!pool_alive(pool, entities[i])) continue;
+			tag_remove(&world->hidden, entities[i]);
+			pool_release(pool, entities[i]);
+		}
+	}
+
+	// Removes e from every store and releases its handle.
+	inline void world_destroy_entity(World* world, Entity e) {
+		if (!pool_alive(&world->pool, e)) return;
+		store_remove(&world->hierarchy, e);
+		store_remove(&world->transforms, e);
+		store_remove(&world->mesh_instances, e);
+		tag_remove(&world->hidden, e);
+		pool_release(&world->pool, e);
+	}
+
+	// Appends src's entries for one store to dst, with handles (and whatever fix rewrites) remapped.
+	template<typename T, typename Fix>
+	void world_merge_store(Store<T>* dst, const Store<T>* src, const Entity* remap, Fix fix) {
+		u32 count = (u32)src->data.count;
+		if (count == 0) return;
+		Entity* entities = (Entity*)memory::malloc(count * sizeof(Entity));
+		T* components = (T*)memory::malloc(count * sizeof(T));
+		u32 n = 0;
+		for (u32 i = 0; i < count; i++) {
+			Entity e = remap[entity_index(src->entities.data[i])];
+			if (e == INVALID_ENTITY) continue;
+			entities[n] = e;
+			components[n] = src->data.data[i];
+			fix(&components[n]);
+			n++;
+		}
+		store_add_n(dst, entities, components, n);
+		memory::free(entities);
+		memory::free(components);
+	}
+
+	// Moves every live entity of src into dst: handles are created in one pool_create_n call and each
+	// store is appended with one store_add_n, so the cost is a few linear passes however many
+	// entities there are. Parent links are rewritten to the new handles. remap (may be null) receives
+	// the dst handle per src entity index, INVALID_ENTITY where dst ran out of capacity.
+	// src is left as it was; returns the number of entities merged.
+	inline u32 world_merge(World* dst, const World* src, arr::Array<Entity>* remap) {
+		const EntityPool* src_pool = &src->pool;
+		arr::Array<Entity> table = {};
+		arr::Array<Entity>* map = remap ? remap : &table;
+		arr::array_resize(map, src_pool->next_index);
+		memory::set(map->data, 0xFF, src_pool->next_index * sizeof(Entity));
+
+		Entity* created = (Entity*)memory::malloc((src_pool->count ? src_pool->count : 1) * sizeof(Entity));
+		u32 merged = pool_create_n(&dst->pool, src_pool->count, created);
+		u32 next = 0;
+		pool_each(src_pool, [&](Entity e) {
+			if (next < merged) map->data[entity_index(e)] = created[next++];
+		});
+		memory::free(created);
+
+		const Entity* to_dst = map->data;
+		world_merge_store(&dst->transforms, &src->transforms, to_dst, [](Transform*) {});
+		world_merge_store(&dst->mesh_instances, &src->mesh_instances, to_dst, [](MeshInstance*) {});
+		world_merge_store(&dst->hierarchy, &src->hierarchy, to_dst, [&](HierarchyNode* hn) {
+			hn->parent = pool_alive(src_pool, hn->parent) ? to_dst[entity_index(hn->parent)] : INVALID_ENTITY;
+		});
+		tag_each(&src->hidden, src_pool, [&](Entity e) {
+			Entity d = to_dst[entity_index(e)];
+			if (d != INVALID_ENTITY) tag_add(&dst->hidden, d);
+		});
+
+		arr::array_destroy(&table);
+		return merged;
+	}
+
 }
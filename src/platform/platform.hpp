@@ -11,6 +11,7 @@ namespace platform {
 	void* get_native_window_handle();
 	void get_paint_field_size(u32* width, u32* height);
 	f32 get_delta_time();
+	f64 get_time(); // seconds on the high-resolution clock, safe from any thread
 
 	enum Key : u32 {
         KEY_W,
@@ -50,6 +51,8 @@ namespace platform {
     void editor_set_entity_entries(const arr::Array<EntityEntry>* entries);
     void editor_set_entity_callback(void (*callback)(ecs::Entity e));
     void editor_set_parent_callback(void (*callback)(ecs::Entity child, ecs::Entity parent));
+    void editor_select_entity(ecs::Entity e); // highlights e in the entity list, no callback
+    void editor_set_pick_callback(void (*callback)(u32 x, u32 y)); // right click in the viewport, client pixels
 
     void editor_set_transform(vec3 pos, vec3 rot, vec3 scale);
     void editor_clear_transform();
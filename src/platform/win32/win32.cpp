@@ -70,6 +70,9 @@ namespace {
     using ParentCallback = void (*)(ecs::Entity child, ecs::Entity parent);
     ParentCallback parent_callback = nullptr;
 
+    using PickCallback = void (*)(u32 x, u32 y);
+    PickCallback pick_callback = nullptr;
+
     HWND transform_edits[9] = {};
     bool transform_active = false;
     constexpr int ID_EDIT_TRANSFORM_BASE = 2000;
@@ -236,6 +239,12 @@ namespace platform {
 
     f32 get_delta_time() { return delta_time; }
 
+    f64 get_time() {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return (f64)now.QuadPart / (f64)perf_freq.QuadPart;
+    }
+
     bool is_key_down(Key key) {
         if (key >= KEY_COUNT) return false;
         return key_state[key];
@@ -381,6 +390,15 @@ static LRESULT CALLBACK viewport_proc(HWND hwnd, UINT message, WPARAM wParam, LP
         }
         return 0;
 
+    case WM_RBUTTONDOWN: {
+        i16 x = (i16)LOWORD(lParam);
+        i16 y = (i16)HIWORD(lParam);
+        if (editor_mode && !mouse_captured && pick_callback && x >= 0 && y >= 0) {
+            pick_callback((u32)x, (u32)y);
+        }
+        return 0;
+    }
+
     case WM_KEYDOWN:
     case WM_SYSKEYDOWN: {
         platform::Key k = vk_to_key(wParam);
@@ -895,6 +913,25 @@ namespace platform {
         parent_callback = callback;
     }
 
+    void editor_select_entity(ecs::Entity e) {
+        entity_selected_index = -1;
+        if (entity_entries) {
+            for (usize i = 0; i < entity_entries->count; i++) {
+                if (entity_entries->data[i].entity == e) {
+                    entity_selected_index = (int)i;
+                    break;
+                }
+            }
+        }
+        if (left_panel_hwnd && editor_mode) {
+            InvalidateRect(left_panel_hwnd, nullptr, FALSE);
+        }
+    }
+
+    void editor_set_pick_callback(void (*callback)(u32 x, u32 y)) {
+        pick_callback = callback;
+    }
+
     void editor_set_fps(f32 fps, f32 frame_time_ms) {
         u32 fps_whole = (u32)fps;
         u32 ft_whole = (u32)frame_time_ms;
@@ -0,0 +1,84 @@
+#include "geometry.hpp"
+#include "mesh.hpp"
+#include "../../core/memory.hpp"
+
+namespace opengl {
+
+    // Replaces *buffer with one of new_size bytes holding its first used_size bytes.
+    static void grow_buffer(GLuint* buffer, usize used_size, usize new_size) {
+        GLuint grown;
+        glCreateBuffers(1, &grown);
+        glNamedBufferStorage(grown, (GLsizeiptr)new_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        if (used_size > 0) glCopyNamedBufferSubData(*buffer, grown, 0, 0, (GLsizeiptr)used_size);
+        glDeleteBuffers(1, buffer);
+        *buffer = grown;
+    }
+
+    void geometry_init(GeometryBuffer* geometry, u32 vertex_capacity, u32 index_capacity) {
+        *geometry = {};
+        geometry->vertex_capacity = vertex_capacity;
+        geometry->index_capacity = index_capacity;
+        glCreateVertexArrays(1, &geometry->vao);
+        glCreateBuffers(1, &geometry->vbo);
+        glCreateBuffers(1, &geometry->ibo);
+        glNamedBufferStorage(geometry->vbo, vertex_capacity * sizeof(Vertex), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glNamedBufferStorage(geometry->ibo, index_capacity * sizeof(u32), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glVertexArrayVertexBuffer(geometry->vao, 0, geometry->vbo, 0, sizeof(Vertex));
+        glVertexArrayElementBuffer(geometry->vao, geometry->ibo);
+        mesh_vertex_format(geometry->vao);
+
+        glVertexArrayBindingDivisor(geometry->vao, 1, 1);
+        glVertexArrayAttribIFormat(geometry->vao, 4, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(geometry->vao, 4, 1);
+        glEnableVertexArrayAttrib(geometry->vao, 4);
+    }
+
+    void geometry_destroy(GeometryBuffer* geometry) {
+        glDeleteVertexArrays(1, &geometry->vao);
+        glDeleteBuffers(1, &geometry->vbo);
+        glDeleteBuffers(1, &geometry->ibo);
+        *geometry = {};
+    }
+
+    GeometryRange geometry_add(GeometryBuffer* geometry, const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) {
+        if (geometry->vertex_count + vertex_count > geometry->vertex_capacity) {
+            u32 capacity = geometry->vertex_capacity ? geometry->vertex_capacity * 2 : 1024;
+            while (capacity < geometry->vertex_count + vertex_count) capacity *= 2;
+            grow_buffer(&geometry->vbo, geometry->vertex_count * sizeof(Vertex), capacity * sizeof(Vertex));
+            glVertexArrayVertexBuffer(geometry->vao, 0, geometry->vbo, 0, sizeof(Vertex));
+            geometry->vertex_capacity = capacity;
+        }
+        if (geometry->index_count + index_count > geometry->index_capacity) {
+            u32 capacity = geometry->index_capacity ? geometry->index_capacity * 2 : 1024;
+            while (capacity < geometry->index_count + index_count) capacity *= 2;
+            grow_buffer(&geometry->ibo, geometry->index_count * sizeof(u32), capacity * sizeof(u32));
+            glVertexArrayElementBuffer(geometry->vao, geometry->ibo);
+            geometry->index_capacity = capacity;
+        }
+
+        GeometryRange range = {};
+        range.first_index = geometry->index_count;
+        range.index_count = index_count;
+        range.base_vertex = (i32)geometry->vertex_count;
+        glNamedBufferSubData(geometry->vbo, geometry->vertex_count * sizeof(Vertex), vertex_count * sizeof(Vertex), vertices);
+        glNamedBufferSubData(geometry->ibo, geometry->index_count * sizeof(u32), index_count * sizeof(u32), indices);
+        geometry->vertex_count += vertex_count;
+        geometry->index_count += index_count;
+        return range;
+    }
+
+    void geometry_bind_instance_ids(const GeometryBuffer* geometry, GLuint buffer) {
+        glVertexArrayVertexBuffer(geometry->vao, 1, buffer, 0, sizeof(u32));
+    }
+
+    GLuint instance_ids_create(u32 count) {
+        u32* ids = (u32*)memory::malloc(count * sizeof(u32));
+        for (u32 i = 0; i < count; i++) ids[i] = i;
+        GLuint buffer;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, count * sizeof(u32), ids, 0);
+        memory::free(ids);
+        return buffer;
+    }
+
+}
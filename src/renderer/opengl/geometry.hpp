@@ -0,0 +1,39 @@
+#pragma once
+
+#include "opengl.hpp"
+#include "vertex.hpp"
+
+namespace opengl {
+
+	// Vertex and index storage shared by every mesh behind one VAO, so draws differ only by their
+	// index range and base vertex and a whole frame can go out as one multi-draw-indirect. Meshes
+	// are appended; the buffers grow by copying into larger ones and are released all at once.
+	//
+	// Attribute 4 is a per-instance uint with divisor 1, read from the buffer given to
+	// geometry_bind_instance_ids. Filled with 0, 1, 2, ..., it hands the shader base_instance +
+	// gl_InstanceID, i.e. a draw's own slice of the per-instance buffers.
+	struct GeometryBuffer {
+		GLuint vao;
+		GLuint vbo;
+		GLuint ibo;
+		u32    vertex_count;
+		u32    vertex_capacity;
+		u32    index_count;
+		u32    index_capacity;
+	};
+
+	struct GeometryRange {
+		u32 first_index;
+		u32 index_count;
+		i32 base_vertex;
+	};
+
+	void geometry_init(GeometryBuffer* geometry, u32 vertex_capacity, u32 index_capacity);
+	void geometry_destroy(GeometryBuffer* geometry);
+	GeometryRange geometry_add(GeometryBuffer* geometry, const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count);
+	void geometry_bind_instance_ids(const GeometryBuffer* geometry, GLuint buffer);
+
+	// Immutable buffer holding 0 .. count-1, for geometry_bind_instance_ids.
+	GLuint instance_ids_create(u32 count);
+
+}
@@ -2,6 +2,21 @@
 
 namespace opengl {
 
+    void mesh_vertex_format(GLuint vao) {
+        glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribBinding(vao, 0, 0);
+        glEnableVertexArrayAttrib(vao, 0);
+        glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, 12);
+        glVertexArrayAttribBinding(vao, 1, 0);
+        glEnableVertexArrayAttrib(vao, 1);
+        glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, 24);
+        glVertexArrayAttribBinding(vao, 2, 0);
+        glEnableVertexArrayAttrib(vao, 2);
+        glVertexArrayAttribFormat(vao, 3, 4, GL_FLOAT, GL_FALSE, 32);
+        glVertexArrayAttribBinding(vao, 3, 0);
+        glEnableVertexArrayAttrib(vao, 3);
+    }
+
     Mesh mesh_create(const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count) {
         Mesh mesh = {};
         mesh.index_count = index_count;
@@ -12,18 +27,7 @@ namespace opengl {
         glNamedBufferStorage(mesh.ibo, index_count * sizeof(u32), indices, 0);
         glVertexArrayVertexBuffer(mesh.vao, 0, mesh.vbo, 0, sizeof(Vertex));
         glVertexArrayElementBuffer(mesh.vao, mesh.ibo);
-        glVertexArrayAttribFormat(mesh.vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-        glVertexArrayAttribBinding(mesh.vao, 0, 0);
-        glEnableVertexArrayAttrib(mesh.vao, 0);
-        glVertexArrayAttribFormat(mesh.vao, 1, 3, GL_FLOAT, GL_FALSE, 12);
-        glVertexArrayAttribBinding(mesh.vao, 1, 0);
-        glEnableVertexArrayAttrib(mesh.vao, 1);
-        glVertexArrayAttribFormat(mesh.vao, 2, 2, GL_FLOAT, GL_FALSE, 24);
-        glVertexArrayAttribBinding(mesh.vao, 2, 0);
-        glEnableVertexArrayAttrib(mesh.vao, 2);
-        glVertexArrayAttribFormat(mesh.vao, 3, 4, GL_FLOAT, GL_FALSE, 32);
-        glVertexArrayAttribBinding(mesh.vao, 3, 0);
-        glEnableVertexArrayAttrib(mesh.vao, 3);
+        mesh_vertex_format(mesh.vao);
 
         return mesh;
     }
@@ -12,6 +12,9 @@ namespace opengl {
 		u32 index_count;
 	};
 
+	// Points attributes 0-3 (position, normal, uv, tangent) of vao at Vertex data in binding 0.
+	void mesh_vertex_format(GLuint vao);
+
 	Mesh mesh_create(const Vertex* vertices, u32 vertex_count, const u32* indices, u32 index_count);
 	void mesh_destroy(Mesh* mesh);
 	void mesh_draw(const Mesh& mesh);
@@ -69,6 +69,19 @@ namespace opengl {
     PFNGLGENERATETEXTUREMIPMAPPROC glGenerateTextureMipmap = nullptr;
     PFNGLBINDTEXTUREUNITPROC     glBindTextureUnit = nullptr;
     PFNGLDELETETEXTURESPROC      glDeleteTextures = nullptr;
+    PFNGLBINDBUFFERPROC          glBindBuffer = nullptr;
+    PFNGLBINDBUFFERRANGEPROC     glBindBufferRange = nullptr;
+    PFNGLUNMAPNAMEDBUFFERPROC    glUnmapNamedBuffer = nullptr;
+    PFNGLCOPYNAMEDBUFFERSUBDATAPROC    glCopyNamedBufferSubData = nullptr;
+    PFNGLVERTEXARRAYATTRIBIFORMATPROC  glVertexArrayAttribIFormat = nullptr;
+    PFNGLVERTEXARRAYBINDINGDIVISORPROC glVertexArrayBindingDivisor = nullptr;
+    PFNGLDISPATCHCOMPUTEPROC     glDispatchCompute = nullptr;
+    PFNGLMEMORYBARRIERPROC       glMemoryBarrier = nullptr;
+    PFNGLUNIFORM4FVPROC          glUniform4fv = nullptr;
+
+    PFNGLGETTEXTUREHANDLEARBPROC            glGetTextureHandleARB = nullptr;
+    PFNGLMAKETEXTUREHANDLERESIDENTARBPROC    glMakeTextureHandleResidentARB = nullptr;
+    PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB = nullptr;
 
 	namespace {
 
@@ -151,6 +164,24 @@ namespace opengl {
         glGenerateTextureMipmap = (PFNGLGENERATETEXTUREMIPMAPPROC)get_gl_proc("glGenerateTextureMipmap");
         glBindTextureUnit = (PFNGLBINDTEXTUREUNITPROC)get_gl_proc("glBindTextureUnit");
         glDeleteTextures = (PFNGLDELETETEXTURESPROC)GetProcAddress(opengl_dll, "glDeleteTextures");
+        glBindBuffer = (PFNGLBINDBUFFERPROC)get_gl_proc("glBindBuffer");
+        glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC)get_gl_proc("glBindBufferRange");
+        glUnmapNamedBuffer = (PFNGLUNMAPNAMEDBUFFERPROC)get_gl_proc("glUnmapNamedBuffer");
+        glCopyNamedBufferSubData = (PFNGLCOPYNAMEDBUFFERSUBDATAPROC)get_gl_proc("glCopyNamedBufferSubData");
+        glVertexArrayAttribIFormat = (PFNGLVERTEXARRAYATTRIBIFORMATPROC)get_gl_proc("glVertexArrayAttribIFormat");
+        glVertexArrayBindingDivisor = (PFNGLVERTEXARRAYBINDINGDIVISORPROC)get_gl_proc("glVertexArrayBindingDivisor");
+        glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)get_gl_proc("glDispatchCompute");
+        glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)get_gl_proc("glMemoryBarrier");
+        glUniform4fv = (PFNGLUNIFORM4FVPROC)get_gl_proc("glUniform4fv");
+
+        glGetTextureHandleARB = (PFNGLGETTEXTUREHANDLEARBPROC)get_gl_proc("glGetTextureHandleARB");
+        glMakeTextureHandleResidentARB = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)get_gl_proc("glMakeTextureHandleResidentARB");
+        glMakeTextureHandleNonResidentARB = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)get_gl_proc("glMakeTextureHandleNonResidentARB");
+        if (!glGetTextureHandleARB || !glMakeTextureHandleResidentARB || !glMakeTextureHandleNonResidentARB) {
+            glGetTextureHandleARB = nullptr;
+            glMakeTextureHandleResidentARB = nullptr;
+            glMakeTextureHandleNonResidentARB = nullptr;
+        }
 
         return true;
     }
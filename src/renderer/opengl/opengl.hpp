@@ -32,6 +32,7 @@ namespace opengl {
 	constexpr GLenum GL_UNSIGNED_INT = 0x1405;
 	constexpr GLenum GL_VERTEX_SHADER = 0x8B31;
 	constexpr GLenum GL_FRAGMENT_SHADER = 0x8B30;
+	constexpr GLenum GL_COMPUTE_SHADER = 0x91B9;
 	constexpr GLenum GL_COMPILE_STATUS = 0x8B81;
 	constexpr GLenum GL_LINK_STATUS = 0x8B82;
 	constexpr GLenum GL_MAP_WRITE_BIT = 0x0002;
@@ -46,6 +47,10 @@ namespace opengl {
 	constexpr GLenum GL_TIMEOUT_EXPIRED = 0x911B;
 	constexpr GLenum GL_WAIT_FAILED = 0x911D;
 	constexpr GLuint64 GL_TIMEOUT_IGNORED = 0xFFFFFFFFFFFFFFFFull;
+	constexpr GLbitfield GL_SYNC_FLUSH_COMMANDS_BIT = 0x00000001;
+	constexpr GLbitfield GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT = 0x00000001;
+	constexpr GLbitfield GL_COMMAND_BARRIER_BIT = 0x00000040;
+	constexpr GLbitfield GL_BUFFER_UPDATE_BARRIER_BIT = 0x00000200;
 	constexpr GLenum GL_DEPTH_TEST = 0x0B71;
 	constexpr GLenum GL_CULL_FACE = 0x0B44;
 
@@ -115,6 +120,27 @@ namespace opengl {
 	using PFNGLGENERATETEXTUREMIPMAPPROC = void (*)(GLuint texture);
 	using PFNGLBINDTEXTUREUNITPROC = void (*)(GLuint unit, GLuint texture);
 	using PFNGLDELETETEXTURESPROC = void (*)(GLsizei n, const GLuint* textures);
+	using PFNGLBINDBUFFERPROC = void (*)(GLenum target, GLuint buffer);
+	using PFNGLBINDBUFFERRANGEPROC = void (*)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	using PFNGLUNMAPNAMEDBUFFERPROC = GLboolean(*)(GLuint buffer);
+	using PFNGLCOPYNAMEDBUFFERSUBDATAPROC = void (*)(GLuint read_buffer, GLuint write_buffer, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size);
+	using PFNGLVERTEXARRAYATTRIBIFORMATPROC = void (*)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+	using PFNGLVERTEXARRAYBINDINGDIVISORPROC = void (*)(GLuint vaobj, GLuint bindingindex, GLuint divisor);
+	using PFNGLGETTEXTUREHANDLEARBPROC = GLuint64(*)(GLuint texture);
+	using PFNGLMAKETEXTUREHANDLERESIDENTARBPROC = void (*)(GLuint64 handle);
+	using PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC = void (*)(GLuint64 handle);
+	using PFNGLDISPATCHCOMPUTEPROC = void (*)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+	using PFNGLMEMORYBARRIERPROC = void (*)(GLbitfield barriers);
+	using PFNGLUNIFORM4FVPROC = void (*)(GLint location, GLsizei count, const GLfloat* value);
+
+	// Layout glMultiDrawElementsIndirect reads from the GL_DRAW_INDIRECT_BUFFER
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint  base_vertex;
+		GLuint base_instance;
+	};
 
 	extern PFNGLCLEARPROC              glClear;
 	extern PFNGLCLEARCOLORPROC         glClearColor;
@@ -165,6 +191,20 @@ namespace opengl {
 	extern PFNGLGENERATETEXTUREMIPMAPPROC glGenerateTextureMipmap;
 	extern PFNGLBINDTEXTUREUNITPROC    glBindTextureUnit;
 	extern PFNGLDELETETEXTURESPROC     glDeleteTextures;
+	extern PFNGLBINDBUFFERPROC         glBindBuffer;
+	extern PFNGLBINDBUFFERRANGEPROC    glBindBufferRange;
+	extern PFNGLUNMAPNAMEDBUFFERPROC   glUnmapNamedBuffer;
+	extern PFNGLCOPYNAMEDBUFFERSUBDATAPROC    glCopyNamedBufferSubData;
+	extern PFNGLVERTEXARRAYATTRIBIFORMATPROC  glVertexArrayAttribIFormat;
+	extern PFNGLVERTEXARRAYBINDINGDIVISORPROC glVertexArrayBindingDivisor;
+	extern PFNGLDISPATCHCOMPUTEPROC    glDispatchCompute;
+	extern PFNGLMEMORYBARRIERPROC      glMemoryBarrier;
+	extern PFNGLUNIFORM4FVPROC         glUniform4fv;
+
+	// GL_ARB_bindless_texture, null when the driver doesn't expose it
+	extern PFNGLGETTEXTUREHANDLEARBPROC            glGetTextureHandleARB;
+	extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC    glMakeTextureHandleResidentARB;
+	extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB;
 
 	bool init(void* hwnd, u32 width, u32 height);
 	void shutdown();
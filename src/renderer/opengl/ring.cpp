@@ -0,0 +1,71 @@
+#include "ring.hpp"
+#include "../../core/log.hpp"
+#include "../../core/memory.hpp"
+
+namespace opengl {
+
+    namespace {
+        constexpr GLuint64 RING_WAIT_NS = 1000000000ull; // warn when a region is still busy after a second
+    }
+
+    void ring_init(StreamRing* ring, usize region_size) {
+        *ring = {};
+        ring->region_size = region_size;
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &ring->buffer);
+        glNamedBufferStorage(ring->buffer, (GLsizeiptr)(region_size * RING_REGIONS), nullptr, flags);
+        ring->mapped = (byte*)glMapNamedBufferRange(ring->buffer, 0, (GLsizeiptr)(region_size * RING_REGIONS), flags);
+        if (ring->mapped) return;
+
+        // Immutable storage can't take glNamedBufferSubData without the dynamic bit, so start over
+        logger::error("ring: could not map %llu bytes, uploading each frame instead", (unsigned long long)(region_size * RING_REGIONS));
+        glDeleteBuffers(1, &ring->buffer);
+        glCreateBuffers(1, &ring->buffer);
+        glNamedBufferStorage(ring->buffer, (GLsizeiptr)(region_size * RING_REGIONS), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        ring->staging = (byte*)memory::malloc(region_size);
+    }
+
+    void ring_destroy(StreamRing* ring) {
+        for (u32 i = 0; i < RING_REGIONS; i++) {
+            if (ring->fences[i]) glDeleteSync(ring->fences[i]);
+        }
+        if (ring->mapped) glUnmapNamedBuffer(ring->buffer);
+        if (ring->staging) memory::free(ring->staging);
+        glDeleteBuffers(1, &ring->buffer);
+        *ring = {};
+    }
+
+    byte* ring_begin(StreamRing* ring) {
+        GLsync fence = ring->fences[ring->current];
+        if (fence) {
+            for (;;) {
+                GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, RING_WAIT_NS);
+                if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+                if (result == GL_WAIT_FAILED) {
+                    logger::error("ring: fence wait failed");
+                    break;
+                }
+                logger::warn("ring: region %u still in use after 1 s", ring->current);
+            }
+            glDeleteSync(fence);
+            ring->fences[ring->current] = nullptr;
+        }
+        if (ring->staging) return ring->staging;
+        return ring->mapped + ring_offset(ring);
+    }
+
+    void ring_flush(StreamRing* ring, usize offset, usize size) {
+        if (!ring->staging || size == 0) return;
+        glNamedBufferSubData(ring->buffer, (GLintptr)(ring_offset(ring) + offset), (GLsizeiptr)size, ring->staging + offset);
+    }
+
+    usize ring_offset(const StreamRing* ring) {
+        return ring->current * ring->region_size;
+    }
+
+    void ring_end(StreamRing* ring) {
+        ring->fences[ring->current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring->current = (ring->current + 1) % RING_REGIONS;
+    }
+
+}
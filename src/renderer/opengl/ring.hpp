@@ -0,0 +1,37 @@
+#pragma once
+
+#include "opengl.hpp"
+
+namespace opengl {
+
+	constexpr u32 RING_REGIONS = 3;
+
+	// Persistently mapped, coherent buffer split into RING_REGIONS per-frame regions. The CPU writes
+	// a frame's data straight into the mapped region; ring_end fences it after the frame's draws and
+	// ring_begin waits on that fence before the region is handed out again, RING_REGIONS frames on.
+	//
+	// If the driver won't map the buffer, ring_begin hands out one CPU staging region instead and
+	// ring_flush uploads the written ranges with glNamedBufferSubData. Callers flush every range
+	// they wrote before the GPU reads it; with a mapped ring that costs nothing.
+	struct StreamRing {
+		GLuint buffer;
+		byte*  mapped;
+		byte*  staging; // region_size bytes, only when mapping failed
+		usize  region_size;
+		GLsync fences[RING_REGIONS];
+		u32    current;
+	};
+
+	void ring_init(StreamRing* ring, usize region_size);
+	void ring_destroy(StreamRing* ring);
+
+	// Waits until the GPU is done with the current region and returns its mapped memory.
+	byte* ring_begin(StreamRing* ring);
+	// Makes [offset, offset + size) of the current region visible to the GPU.
+	void ring_flush(StreamRing* ring, usize offset, usize size);
+	// Byte offset of the current region in ring->buffer, for binds and indirect pointers.
+	usize ring_offset(const StreamRing* ring);
+	// Fences the current region after the commands reading it and moves to the next one.
+	void ring_end(StreamRing* ring);
+
+}
@@ -92,6 +92,30 @@ namespace opengl {
         return program;
     }
 
+    GLuint shader_create_compute(const char* comp_path) {
+        GLuint comp = compile_shader(GL_COMPUTE_SHADER, comp_path);
+        if (!comp) return 0;
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, comp);
+        glLinkProgram(program);
+
+        glDeleteShader(comp);
+
+        GLint status = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+        if (!status) {
+            char info[1024];
+            glGetProgramInfoLog(program, sizeof(info), nullptr, info);
+            logger::error("shader: link error (%s):\n%s", comp_path, info);
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
     void shader_destroy(GLuint program) {
         if (program) glDeleteProgram(program);
     }
@@ -124,8 +148,35 @@ namespace opengl {
         return true;
     }
 
+    static bool on_comp_found(const char* filename, void* userdata) {
+        const char* folder = static_cast<const char*>(userdata);
+        usize name_len = str::length(filename) - 5;
+
+        if (name_len == 0 || name_len >= 64) {
+            logger::warn("shader_load: skipping %s", filename);
+            return true;
+        }
+
+        char name[64] = {};
+        memory::copy(name, filename, name_len);
+
+        char comp_path[256];
+        str::format(comp_path, sizeof(comp_path), "%s/%s.comp", folder, name);
+
+        GLuint program = shader_create_compute(comp_path);
+        if (!program) return true;
+
+        ShaderEntry entry = {};
+        str::copy(entry.name, name, sizeof(entry.name));
+        entry.program = program;
+        arr::array_push(&registry, entry);
+
+        return true;
+    }
+
     bool shader_load(const char* folder) {
         file::file_visit(folder, ".frag", on_frag_found, (void*)folder);
+        file::file_visit(folder, ".comp", on_comp_found, (void*)folder);
         return true;
     }
 
@@ -3,6 +3,7 @@
 
 namespace opengl {
 	GLuint shader_create(const char* vert_path, const char* frag_path);
+	GLuint shader_create_compute(const char* comp_path);
 	void shader_destroy(GLuint program);
 	bool shader_load(const char* folder);
 	GLuint shader_get(const char* name);
@@ -12,32 +12,49 @@ namespace opengl {
 		return levels;
 	}
 
-	GLuint texture_load(const char* filepath) {
-		int w, h, channels;
-		stbi_set_flip_vertically_on_load(1);
-		u8* pixels = stbi_load(filepath, &w, &h, &channels, 0);
-		if (!pixels) {
+	bool image_load(const char* filepath, Image* out) {
+		*out = {};
+		stbi_set_flip_vertically_on_load_thread(1);
+		out->pixels = stbi_load(filepath, &out->width, &out->height, &out->channels, 0);
+		if (!out->pixels) {
 			logger::error("texture: failed to load '%s'", filepath);
-			return 0;
+			return false;
 		}
+		return true;
+	}
+
+	void image_free(Image* image) {
+		if (image->pixels) stbi_image_free(image->pixels);
+		*image = {};
+	}
 
-		GLenum internal_fmt = (channels == 4) ? GL_SRGB8_ALPHA8 : GL_SRGB8;
-		GLenum upload_fmt = (channels == 4) ? GL_RGBA : GL_RGB;
-		GLsizei mip_levels = calc_mip_levels((GLsizei)w, (GLsizei)h);
+	GLuint texture_create(const Image* image) {
+		if (!image->pixels) return 0;
+		GLsizei w = (GLsizei)image->width;
+		GLsizei h = (GLsizei)image->height;
+		GLenum internal_fmt = (image->channels == 4) ? GL_SRGB8_ALPHA8 : GL_SRGB8;
+		GLenum upload_fmt = (image->channels == 4) ? GL_RGBA : GL_RGB;
+		GLsizei mip_levels = calc_mip_levels(w, h);
 
 		GLuint tex;
 		glCreateTextures(GL_TEXTURE_2D, 1, &tex);
-		glTextureStorage2D(tex, mip_levels, internal_fmt, (GLsizei)w, (GLsizei)h);
-		glTextureSubImage2D(tex, 0, 0, 0, (GLsizei)w, (GLsizei)h, upload_fmt, GL_UNSIGNED_BYTE, pixels);
+		glTextureStorage2D(tex, mip_levels, internal_fmt, w, h);
+		glTextureSubImage2D(tex, 0, 0, 0, w, h, upload_fmt, GL_UNSIGNED_BYTE, image->pixels);
 		glGenerateTextureMipmap(tex);
 
 		glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		return tex;
+	}
 
-		stbi_image_free(pixels);
-		logger::info("texture: loaded '%s' (%dx%d, %dch)", filepath, w, h, channels);
+	GLuint texture_load(const char* filepath) {
+		Image image;
+		if (!image_load(filepath, &image)) return 0;
+		GLuint tex = texture_create(&image);
+		logger::info("texture: loaded '%s' (%dx%d, %dch)", filepath, image.width, image.height, image.channels);
+		image_free(&image);
 		return tex;
 	}
 
@@ -56,4 +73,15 @@ namespace opengl {
 		if (tex) glDeleteTextures(1, &tex);
 	}
 
+	GLuint64 texture_make_resident(GLuint tex) {
+		if (!tex || !glGetTextureHandleARB) return 0;
+		GLuint64 handle = glGetTextureHandleARB(tex);
+		if (handle) glMakeTextureHandleResidentARB(handle);
+		return handle;
+	}
+
+	void texture_make_non_resident(GLuint64 handle) {
+		if (handle && glMakeTextureHandleNonResidentARB) glMakeTextureHandleNonResidentARB(handle);
+	}
+
 }
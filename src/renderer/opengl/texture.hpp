@@ -4,8 +4,25 @@
 
 namespace opengl {
 
+	// Decoded pixels, produced off the GL thread and uploaded with texture_create.
+	struct Image {
+		u8* pixels;
+		i32 width;
+		i32 height;
+		i32 channels;
+	};
+
+	bool   image_load(const char* filepath, Image* out); // safe on any thread
+	void   image_free(Image* image);
+
+	GLuint texture_create(const Image* image);
 	GLuint texture_load(const char* filepath);
 	GLuint texture_create_solid(u8 r, u8 g, u8 b, u8 a);
 	void   texture_destroy(GLuint tex);
 
+	// Resident bindless handle for tex, or 0 when GL_ARB_bindless_texture is unavailable.
+	// Make it non-resident before destroying the texture.
+	GLuint64 texture_make_resident(GLuint tex);
+	void     texture_make_non_resident(GLuint64 handle);
+
 }
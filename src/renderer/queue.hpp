@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../core/types.hpp"
+
+// Draw order for a frame: one 64-bit key per visible instance, radix-sorted so instances that
+// share a program, texture and asset are adjacent, nearest first within each run. A run of equal
+// state (the key without its depth bits) becomes one instanced draw.
+//
+//   63      56 55           40 39           20 19            0
+//   | program |    texture    |     asset     |     depth     |
+
+namespace renderer {
+
+	constexpr u32 QUEUE_DEPTH_BITS = 20;
+	constexpr u32 QUEUE_ASSET_BITS = 20;
+	constexpr u32 QUEUE_TEXTURE_BITS = 16;
+	constexpr u32 QUEUE_PROGRAM_BITS = 8;
+
+	constexpr u32 QUEUE_ASSET_SHIFT = QUEUE_DEPTH_BITS;
+	constexpr u32 QUEUE_TEXTURE_SHIFT = QUEUE_ASSET_SHIFT + QUEUE_ASSET_BITS;
+	constexpr u32 QUEUE_PROGRAM_SHIFT = QUEUE_TEXTURE_SHIFT + QUEUE_TEXTURE_BITS;
+
+	// Program, texture and asset bits of a key. Fields wider than their bits are truncated, which
+	// only costs batching: runs still split wherever the asset differs.
+	inline u64 queue_state(u32 program, u32 texture, u32 asset) {
+		return ((u64)(program & ((1u << QUEUE_PROGRAM_BITS) - 1)) << QUEUE_PROGRAM_SHIFT)
+			| ((u64)(texture & ((1u << QUEUE_TEXTURE_BITS) - 1)) << QUEUE_TEXTURE_SHIFT)
+			| ((u64)(asset & ((1u << QUEUE_ASSET_BITS) - 1)) << QUEUE_ASSET_SHIFT);
+	}
+
+	// View depth mapped linearly onto [0, far] and clamped.
+	inline u64 queue_depth(f32 depth, f32 far) {
+		constexpr u32 max_depth = (1u << QUEUE_DEPTH_BITS) - 1;
+		if (depth <= 0.0f) return 0;
+		if (depth >= far) return max_depth;
+		return (u64)(depth / far * (f32)max_depth);
+	}
+
+	inline u64 queue_key_state(u64 key) {
+		return key >> QUEUE_DEPTH_BITS;
+	}
+
+}
@@ -1,6 +1,7 @@
 #include "scene.hpp"
 #include "json.hpp"
 #include "../ecs/world.hpp"
+#include "../ecs/hierarchy.hpp"
 #include "../core/log.hpp"
 #include "../core/file.hpp"
 #include "../core/memory.hpp"
@@ -62,10 +63,17 @@ namespace scene {
 		out[name_len] = '\0';
 	}
 
-	bool load(Scene* scene, const char* filepath, ecs::World* world) {
-		*scene = {};
-		extract_name(filepath, scene->name, sizeof(scene->name));
-		str::copy(scene->path, filepath, sizeof(scene->path));
+	static i32 find_staged_asset(const SceneStage* stage, const char* name) {
+		for (usize i = 0; i < stage->assets.count; i++) {
+			if (str::equal(stage->assets.data[i].name, name)) return (i32)i;
+		}
+		return -1;
+	}
+
+	bool stage(SceneStage* stage, const char* filepath) {
+		*stage = {};
+		extract_name(filepath, stage->name, sizeof(stage->name));
+		str::copy(stage->path, filepath, sizeof(stage->path));
 
 		u64 file_size = 0;
 		if (!file::get_size(filepath, &file_size)) {
@@ -89,68 +97,181 @@ namespace scene {
 		u32 asset_count = json::length(assets_arr);
 		for (u32 i = 0; i < asset_count; i++) {
 			const char* asset_path = json::as_string(json::at(assets_arr, i));
-			if (asset_path[0]) asset::load(asset_path);
+			if (!asset_path[0]) continue;
+			bool listed = false;
+			for (usize j = 0; j < stage->assets.count && !listed; j++) listed = str::equal(stage->assets.data[j].path, asset_path);
+			if (listed) continue;
+
+			asset::AssetData data;
+			if (asset::decode(asset_path, &data)) arr::array_push(&stage->assets, data);
+			else asset::data_destroy(&data);
 		}
 
 		json::Value* entities_arr = json::get(root, "entities");
 		u32 entity_count = json::length(entities_arr);
-		arr::Array<ecs::Entity> index_to_entity = {};
 
-		for (u32 i = 0; i < entity_count; i++) {
+		ecs::World* world = &stage->world;
+		ecs::world_init(world, entity_count > 0 ? entity_count : 1);
+
+		// Handles for the whole file in one call; components are staged per store and added in bulk
+		arr::Array<ecs::Entity>& index_to_entity = stage->entities;
+		arr::array_resize(&index_to_entity, entity_count);
+		u32 created = ecs::pool_create_n(&world->pool, entity_count, index_to_entity.data);
+
+		arr::Array<ecs::Entity> transform_entities = {};
+		arr::Array<ecs::Transform> transforms = {};
+		arr::Array<ecs::Entity> mesh_entities = {};
+		arr::Array<ecs::MeshInstance> meshes = {};
+		arr::Array<ecs::HierarchyNode> nodes = {};
+		arr::Array<i32> parent_indices = {};
+		arr::Array<u32> name_counts = {}; // per canonical asset index + 1, slot 0 is "Entity"
+		arr::array_reserve(&transform_entities, created);
+		arr::array_reserve(&transforms, created);
+		arr::array_reserve(&mesh_entities, created);
+		arr::array_reserve(&meshes, created);
+		arr::array_resize(&nodes, created);
+		arr::array_resize(&parent_indices, created);
+
+		for (u32 i = 0; i < created; i++) {
 			json::Value* ent_json = json::at(entities_arr, i);
-			if (!ent_json) continue;
-
-			ecs::Entity e = ecs::pool_create(&world->pool);
-			if (e == ecs::INVALID_ENTITY) break;
-			arr::array_push(&scene->entities, e);
-			arr::array_push(&index_to_entity, e);
+			ecs::Entity e = index_to_entity.data[i];
+			bool has_transform = false;
+			i32 mesh_asset = -1;
 
-			json::Value* t = json::get(ent_json, "transform");
+			json::Value* t = ent_json ? json::get(ent_json, "transform") : nullptr;
 			if (t) {
 				ecs::Transform transform = {};
 				transform.position = json_to_vec3(json::get(t, "position"));
-				transform.rotation = json_to_vec3(json::get(t, "rotation"));
+				transform.rotation = quat_from_euler(json_to_vec3(json::get(t, "rotation")));
 				transform.scale    = json_to_vec3(json::get(t, "scale"), {1, 1, 1});
-				transform.local_to_world = mat4_identity();
-				ecs::store_add(&world->transforms, e, transform);
+				transform.local_to_world = mat3x4_identity();
+				arr::array_push(&transform_entities, e);
+				arr::array_push(&transforms, transform);
+				has_transform = true;
 			}
 
-			json::Value* mi = json::get(ent_json, "mesh_instance");
+			json::Value* mi = ent_json ? json::get(ent_json, "mesh_instance") : nullptr;
 			if (mi) {
 				const char* asset_name = json::as_string(json::get(mi, "asset"));
-				i32 id = asset::find_id(asset_name);
-				if (id >= 0) {
-					ecs::store_add(&world->mesh_instances, e, { (u32)id });
+				mesh_asset = find_staged_asset(stage, asset_name);
+				if (mesh_asset >= 0) {
+					arr::array_push(&mesh_entities, e);
+					arr::array_push(&meshes, ecs::MeshInstance{ (u32)mesh_asset });
+					if (!has_transform) {
+						// Renderable entities always carry a transform so render views can require one
+						ecs::Transform transform = {};
+						transform.rotation = quat_identity();
+						transform.scale = { 1, 1, 1 };
+						transform.local_to_world = mat3x4_identity();
+						arr::array_push(&transform_entities, e);
+						arr::array_push(&transforms, transform);
+					}
 				} else {
 					logger::error("scene: entity references unknown asset '%s'", asset_name);
 				}
 			}
 
-			ecs::HierarchyNode hn = {};
-			hn.parent = ecs::INVALID_ENTITY;
+			if (ent_json && json::as_bool(json::get(ent_json, "hidden"))) ecs::tag_add(&world->hidden, e);
 
-			json::Value* parent_val = json::get(ent_json, "parent");
-			if (parent_val) {
-				i32 parent_idx = (i32)json::as_number(parent_val, -1.0);
-				if (parent_idx >= 0 && parent_idx < (i32)index_to_entity.count) {
-					hn.parent = index_to_entity.data[parent_idx];
-				}
-			}
+			ecs::HierarchyNode* hn = &nodes.data[i];
+			*hn = {};
+			hn->parent = ecs::INVALID_ENTITY;
 
+			// Parents may be listed after their children; links are resolved once every entity exists
+			json::Value* parent_val = ent_json ? json::get(ent_json, "parent") : nullptr;
+			parent_indices.data[i] = parent_val ? (i32)json::as_number(parent_val, -1.0) : -1;
+
+			// Same names make_entity_name would give, counted per base instead of rescanning the scene.
+			// Assets sharing a name share a counter through the first asset with that name.
 			const char* base = "Entity";
-			if (ecs::store_has(&world->mesh_instances, e)) {
-				ecs::MeshInstance* mesh_inst = ecs::store_get(&world->mesh_instances, e);
-				asset::Asset* a = asset::get(mesh_inst->asset_id);
-				if (a) base = a->name;
+			u32 slot = 0;
+			if (mesh_asset >= 0) {
+				base = stage->assets.data[mesh_asset].name;
+				slot = (u32)find_staged_asset(stage, base) + 1;
+			}
+			while (name_counts.count <= slot) arr::array_push(&name_counts, 0u);
+			u32 n = name_counts.data[slot]++;
+			if (n == 0) str::copy(hn->name, base, sizeof(hn->name));
+			else str::format(hn->name, sizeof(hn->name), "%s.%03u", base, n);
+		}
+
+		ecs::store_add_n(&world->transforms, transform_entities.data, transforms.data, (u32)transforms.count);
+		ecs::store_add_n(&world->mesh_instances, mesh_entities.data, meshes.data, (u32)meshes.count);
+		ecs::store_add_n(&world->hierarchy, index_to_entity.data, nodes.data, created);
+
+		arr::array_destroy(&transform_entities);
+		arr::array_destroy(&transforms);
+		arr::array_destroy(&mesh_entities);
+		arr::array_destroy(&meshes);
+		arr::array_destroy(&nodes);
+		arr::array_destroy(&name_counts);
+
+		for (usize i = 0; i < parent_indices.count; i++) {
+			i32 parent_idx = parent_indices.data[i];
+			if (parent_idx < 0 || parent_idx >= (i32)index_to_entity.count) continue;
+			if (!ecs::hierarchy_set_parent(world, index_to_entity.data[i], index_to_entity.data[parent_idx])) {
+				logger::error("scene: entity %u has an invalid parent %d", (u32)i, parent_idx);
 			}
-			make_entity_name(base, world, scene, hn.name, sizeof(hn.name));
-			ecs::store_add(&world->hierarchy, e, hn);
 		}
 
-		arr::array_destroy(&index_to_entity);
+		arr::array_destroy(&parent_indices);
 
 		json::destroy(root);
-		logger::info("scene: loaded '%s' (%u entities)", filepath, (u32)scene->entities.count);
+		stage->loaded = true;
+		return true;
+	}
+
+	void stage_destroy(SceneStage* stage) {
+		for (usize i = 0; i < stage->assets.count; i++) asset::data_destroy(&stage->assets.data[i]);
+		arr::array_destroy(&stage->assets);
+		arr::array_destroy(&stage->entities);
+		ecs::world_destroy(&stage->world);
+		*stage = {};
+	}
+
+	void commit(Scene* scene, SceneStage* stage, ecs::World* world) {
+		*scene = {};
+		str::copy(scene->name, stage->name, sizeof(scene->name));
+		str::copy(scene->path, stage->path, sizeof(scene->path));
+
+		// Staged asset indices become registry ids
+		u32 asset_count = (u32)stage->assets.count;
+		u32* asset_ids = (u32*)memory::malloc((asset_count ? asset_count : 1) * sizeof(u32));
+		for (u32 i = 0; i < asset_count; i++) asset_ids[i] = (u32)asset::upload(&stage->assets.data[i]);
+		ecs::Store<ecs::MeshInstance>* meshes = &stage->world.mesh_instances;
+		for (usize i = 0; i < meshes->data.count; i++) {
+			meshes->data.data[i].asset_id = asset_ids[meshes->data.data[i].asset_id];
+		}
+		memory::free(asset_ids);
+
+		arr::Array<ecs::Entity> remap = {};
+		u32 staged = stage->world.pool.count;
+		u32 merged = ecs::world_merge(world, &stage->world, &remap);
+		if (merged < staged) {
+			logger::error("scene: entity capacity reached, loading %u of %u entities", merged, staged);
+		}
+
+		arr::array_reserve(&scene->entities, merged);
+		for (usize i = 0; i < stage->entities.count; i++) {
+			ecs::Entity e = remap.data[ecs::entity_index(stage->entities.data[i])];
+			if (e != ecs::INVALID_ENTITY) arr::array_push(&scene->entities, e);
+		}
+		arr::array_destroy(&remap);
+
+		stage_destroy(stage);
+		logger::info("scene: loaded '%s' (%u entities)", scene->path, (u32)scene->entities.count);
+	}
+
+	bool load(Scene* scene, const char* filepath, ecs::World* world) {
+		SceneStage staging;
+		if (!stage(&staging, filepath)) {
+			*scene = {};
+			str::copy(scene->name, staging.name, sizeof(scene->name));
+			str::copy(scene->path, staging.path, sizeof(scene->path));
+			stage_destroy(&staging);
+			return false;
+		}
+		commit(scene, &staging, world);
 		return true;
 	}
 
@@ -202,16 +323,13 @@ namespace scene {
 		w.indent = 2;
 
 		arr::Array<u32> seen_assets = {};
-		for (usize i = 0; i < scene->entities.count; i++) {
-			ecs::Entity e = scene->entities.data[i];
-			if (!ecs::store_has(&world->mesh_instances, e)) continue;
-			const ecs::MeshInstance* mi = ecs::store_get(
-				const_cast<ecs::Store<ecs::MeshInstance>*>(&world->mesh_instances), e);
+		for (usize i = 0; i < world->mesh_instances.data.count; i++) {
+			u32 asset_id = world->mesh_instances.data.data[i].asset_id;
 			bool found = false;
 			for (usize j = 0; j < seen_assets.count; j++) {
-				if (seen_assets.data[j] == mi->asset_id) { found = true; break; }
+				if (seen_assets.data[j] == asset_id) { found = true; break; }
 			}
-			if (!found) arr::array_push(&seen_assets, mi->asset_id);
+			if (!found) arr::array_push(&seen_assets, asset_id);
 		}
 
 		for (usize i = 0; i < seen_assets.count; i++) {
@@ -244,7 +362,7 @@ namespace scene {
 				write_indent(&w); write_raw(&w, "\"transform\": {\n");
 				w.indent = 4;
 				write_indent(&w); write_raw(&w, "\"position\": "); write_vec3(&w, t->position); write_raw(&w, ",\n");
-				write_indent(&w); write_raw(&w, "\"rotation\": "); write_vec3(&w, t->rotation); write_raw(&w, ",\n");
+				write_indent(&w); write_raw(&w, "\"rotation\": "); write_vec3(&w, quat_to_euler(t->rotation)); write_raw(&w, ",\n");
 				write_indent(&w); write_raw(&w, "\"scale\": ");    write_vec3(&w, t->scale);    write_raw(&w, "\n");
 				w.indent = 3;
 				write_indent(&w); write_raw(&w, "}");
@@ -282,6 +400,13 @@ namespace scene {
 				}
 			}
 
+			if (ecs::tag_has(&world->hidden, e)) {
+				if (has_prev) write_raw(&w, ",");
+				write_raw(&w, "\n");
+				write_indent(&w); write_raw(&w, "\"hidden\": true");
+				has_prev = true;
+			}
+
 			write_raw(&w, "\n");
 			w.indent = 2;
 			write_indent(&w); write_raw(&w, "}");
@@ -303,13 +428,7 @@ namespace scene {
 	}
 
 	void unload(Scene* scene, ecs::World* world) {
-		for (usize i = 0; i < scene->entities.count; i++) {
-			ecs::Entity e = scene->entities.data[i];
-			ecs::store_remove(&world->hierarchy, e);
-			ecs::store_remove(&world->transforms, e);
-			ecs::store_remove(&world->mesh_instances, e);
-			ecs::pool_release(&world->pool, e);
-		}
+		ecs::world_destroy_entities(world, scene->entities.data, (u32)scene->entities.count);
 		arr::array_destroy(&scene->entities);
 		logger::info("scene: unloaded '%s'", scene->name);
 	}
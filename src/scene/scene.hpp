@@ -2,9 +2,8 @@
 
 #include "../core/types.hpp"
 #include "../core/array.hpp"
-#include "../ecs/ecs.hpp"
-
-namespace ecs { struct World; }
+#include "../ecs/world.hpp"
+#include "../asset/asset.hpp"
 
 namespace scene {
 
@@ -15,7 +14,24 @@ namespace scene {
 		bool                    dirty;
 	};
 
-	bool load(Scene* scene, const char* filepath, ecs::World* world);
+	// A scene file parsed into its own World with its assets decoded, waiting to be committed.
+	// Mesh instances in the staging world hold indices into assets until commit uploads them.
+	struct SceneStage {
+		char                         name[64];
+		char                         path[256];
+		ecs::World                   world;
+		arr::Array<ecs::Entity>      entities; // staging handles in file order
+		arr::Array<asset::AssetData> assets;
+		bool                         loaded;
+	};
+
+	// Any thread: touches neither the live World nor the asset registry.
+	bool stage(SceneStage* stage, const char* filepath);
+	// GL thread: uploads the staged assets, merges the staging world into world and destroys the stage.
+	void commit(Scene* scene, SceneStage* stage, ecs::World* world);
+	void stage_destroy(SceneStage* stage);
+
+	bool load(Scene* scene, const char* filepath, ecs::World* world); // stage + commit
 	bool save(const Scene* scene, const ecs::World* world);
 	void unload(Scene* scene, ecs::World* world);
 	void make_entity_name(const char* base_name, const ecs::World* world, const Scene* scene, char* out, usize out_size);
@@ -0,0 +1,135 @@
+// Runs commands_apply (ecs/commands.hpp) on a small World recorded from two thread buffers and checks:
+//   - surviving adds and removes reach the stores in (component, entity) order,
+//   - only the last add/remove per (component, entity) is applied, later buffers after earlier ones,
+//   - destroys run after every add and remove, including ones recorded after the destroy,
+//   - entities created through a buffer get a handle and their components.
+// Store observers log every change in the order commands_apply makes it.
+//
+// Standalone console program, see run.sh. Exits with 1 on any failure.
+
+#include <stdio.h>
+
+#include "../../src/ecs/world.hpp"
+#include "../../src/ecs/commands.hpp"
+
+static u32 current_thread;
+
+namespace jobs {
+	u32 thread_index() { return current_thread; }
+}
+
+struct Event {
+	u32         component;
+	ecs::Entity entity;
+	u32         event;
+};
+
+static Event events[64];
+static u32   event_count;
+static u32   failures;
+
+static void log_event(void* user, ecs::Entity e, u32 event) {
+	if (event_count < 64) events[event_count++] = { *(const u32*)user, e, event };
+}
+
+static void check(bool ok, const char* what) {
+	if (ok) return;
+	printf("failed: %s\n", what);
+	failures++;
+}
+
+static ecs::Transform transform_at(f32 x) {
+	ecs::Transform t = {};
+	t.position = { x, 0.0f, 0.0f };
+	t.rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+	t.scale = { 1.0f, 1.0f, 1.0f };
+	return t;
+}
+
+static f32 transform_x(ecs::World* world, ecs::Entity e) {
+	const ecs::Transform* t = ecs::store_get(&world->transforms, e);
+	return t ? t->position.x : -1.0f;
+}
+
+int main() {
+	ecs::World world;
+	ecs::world_init(&world, 64);
+	ecs::CommandQueue queue = {};
+
+	ecs::Entity e[8];
+	for (u32 i = 0; i < 8; i++) e[i] = ecs::pool_create(&world.pool);
+	ecs::store_add(&world.transforms, e[0], transform_at(100.0f));
+	ecs::store_add(&world.mesh_instances, e[1], ecs::MeshInstance{ 1 });
+	ecs::store_add(&world.mesh_instances, e[6], ecs::MeshInstance{ 6 });
+
+	u32 transform_id = ecs::component_id<ecs::Transform>();
+	u32 mesh_id = ecs::component_id<ecs::MeshInstance>();
+	ecs::observers_add(&world.transforms.observers, log_event, &transform_id);
+	ecs::observers_add(&world.mesh_instances.observers, log_event, &mesh_id);
+
+	current_thread = 0;
+	ecs::CommandBuffer* main_buffer = ecs::commands_local(&queue);
+	ecs::commands_add(main_buffer, e[3], transform_at(1.0f));
+	ecs::commands_add(main_buffer, e[3], ecs::MeshInstance{ 7 });
+	ecs::commands_add(main_buffer, e[2], transform_at(2.0f));
+	ecs::commands_add(main_buffer, e[3], transform_at(3.0f));
+	ecs::commands_remove<ecs::MeshInstance>(main_buffer, e[1]);
+	ecs::commands_destroy(main_buffer, e[5]);
+	ecs::commands_add(main_buffer, e[5], transform_at(5.0f));
+	ecs::commands_add(main_buffer, e[4], ecs::MeshInstance{ 4 });
+	ecs::commands_remove<ecs::MeshInstance>(main_buffer, e[4]);
+	ecs::PendingEntity pending = ecs::commands_create(main_buffer);
+	ecs::commands_add(main_buffer, pending, transform_at(9.0f));
+
+	current_thread = 2;
+	ecs::CommandBuffer* worker_buffer = ecs::commands_local(&queue);
+	ecs::commands_destroy(worker_buffer, e[6]);
+	ecs::commands_add(worker_buffer, e[3], transform_at(4.0f));
+	ecs::commands_add(worker_buffer, e[0], transform_at(6.0f));
+	ecs::commands_remove<ecs::Transform>(worker_buffer, e[2]);
+
+	current_thread = 0;
+	ecs::commands_apply(&queue, &world);
+	ecs::Entity created = ecs::commands_created(main_buffer, pending);
+
+	// Last write wins, across records in one buffer and across buffers
+	check(transform_x(&world, e[0]) == 6.0f, "e0 keeps the worker's overwrite");
+	check(transform_x(&world, e[3]) == 4.0f, "e3 keeps the worker's add over the main thread's two");
+	check(!ecs::store_has(&world.transforms, e[2]), "e2's add is cancelled by the later remove");
+	check(!ecs::store_has(&world.mesh_instances, e[4]), "e4's add is cancelled by the later remove");
+	check(!ecs::store_has(&world.mesh_instances, e[1]), "e1's mesh is removed");
+	const ecs::MeshInstance* mesh = ecs::store_get(&world.mesh_instances, e[3]);
+	check(mesh && mesh->asset_id == 7, "e3 gets its mesh");
+
+	// Destroys run last
+	check(!ecs::pool_alive(&world.pool, e[5]) && !ecs::pool_alive(&world.pool, e[6]), "e5 and e6 are destroyed");
+	check(!ecs::store_has(&world.transforms, e[5]), "the add recorded after e5's destroy doesn't outlive it");
+
+	// Pending entities
+	check(ecs::pool_alive(&world.pool, created), "the pending entity gets a live handle");
+	check(transform_x(&world, created) == 9.0f, "the pending entity gets its transform");
+
+	// Applied: e0 set, e3, e5 and the pending entity added, then e1 removed and e3 added for meshes.
+	// The cancelled commands raise nothing. Destroys follow in record order: e5's transform, e6's mesh.
+	check(event_count == 8, "8 store events");
+	for (u32 i = 1; i + 2 < event_count && i < 6; i++) {
+		u64 prev = ((u64)events[i - 1].component << 32) | ecs::entity_index(events[i - 1].entity);
+		u64 next = ((u64)events[i].component << 32) | ecs::entity_index(events[i].entity);
+		check(prev < next, "adds and removes are applied in (component, entity) order");
+	}
+	if (event_count == 8) {
+		check(events[6].component == transform_id && events[6].entity == e[5] && events[6].event == ecs::STORE_EVENT_REMOVE, "e5's destroy follows every add");
+		check(events[7].component == mesh_id && events[7].entity == e[6] && events[7].event == ecs::STORE_EVENT_REMOVE, "e6's destroy comes next");
+	}
+
+	// Applied buffers record afresh
+	ecs::commands_add(main_buffer, e[0], transform_at(7.0f));
+	check(ecs::commands_created(main_buffer, pending) == ecs::INVALID_ENTITY, "created handles end with the next record");
+	ecs::commands_apply(&queue, &world);
+	check(transform_x(&world, e[0]) == 7.0f, "a second apply runs the new record");
+
+	printf("%u failures\n", failures);
+	ecs::command_queue_destroy(&queue);
+	ecs::world_destroy(&world);
+	return failures > 0 ? 1 : 0;
+}
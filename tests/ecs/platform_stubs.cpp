@@ -0,0 +1,15 @@
+// Stand-ins for the CRT pieces core/memory.cpp links against on Win32.
+
+#include <stdlib.h>
+
+extern "C" void* _aligned_malloc(size_t size, size_t alignment) {
+	return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+extern "C" void _aligned_free(void* ptr) {
+	free(ptr);
+}
+
+extern "C" long long _InterlockedIncrement64(long long volatile* addend) {
+	return __atomic_add_fetch(addend, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Builds and runs the ECS behavior tests on Linux with g++. They need no GPU or window.
+set -e
+root="$(cd "$(dirname "$0")/../.." && pwd)"
+out="${TMPDIR:-/tmp}"
+for test in commands tags; do
+	g++ -std=c++14 -O1 -include stddef.h \
+		"$root/tests/ecs/${test}_test.cpp" \
+		"$root/tests/ecs/platform_stubs.cpp" \
+		"$root/src/core/memory.cpp" \
+		-o "$out/ecs_${test}_test"
+	"$out/ecs_${test}_test"
+done
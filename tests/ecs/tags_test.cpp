@@ -0,0 +1,116 @@
+// Checks the tag store (ecs/tags.hpp) and how render_snapshots_capture drops hidden entities:
+//   - add/remove/clear keep count and version right and ignore repeats,
+//   - tag_each visits exactly the live tagged entities across word boundaries, with current
+//     handles, and skips released slots whose bit was never cleared,
+//   - a capture leaves hidden mesh instances out of the snapshot and brings them back once shown.
+//
+// Standalone console program, see run.sh. Exits with 1 on any failure.
+
+#include <stdio.h>
+
+#include "../../src/ecs/world.hpp"
+#include "../../src/ecs/snapshot.hpp"
+
+constexpr u32 ENTITY_COUNT = 200; // a few tag words
+
+static u32 failures;
+
+static void check(bool ok, const char* what) {
+	if (ok) return;
+	printf("failed: %s\n", what);
+	failures++;
+}
+
+static bool hidden_index(u32 i) {
+	return i % 7 == 0 || i == 63 || i == 64 || i == 127;
+}
+
+int main() {
+	ecs::World world;
+	ecs::world_init(&world, 256);
+	ecs::Entity e[ENTITY_COUNT];
+	for (u32 i = 0; i < ENTITY_COUNT; i++) e[i] = ecs::pool_create(&world.pool);
+
+	// Counting and versions
+	ecs::TagStore* hidden = &world.hidden;
+	u32 hidden_count = 0;
+	for (u32 i = 0; i < ENTITY_COUNT; i++) {
+		if (!hidden_index(i)) continue;
+		ecs::tag_add(hidden, e[i]);
+		hidden_count++;
+	}
+	u32 version = hidden->version;
+	ecs::tag_add(hidden, e[0]);
+	ecs::tag_remove(hidden, e[1]);
+	check(hidden->count == hidden_count, "count matches the entities tagged");
+	check(hidden->version == version, "repeated adds and removes of absent tags change nothing");
+	check(hidden->words.count == 196 / 64 + 1, "words grow to the highest tagged index");
+
+	// tag_each sees live entities only, with their current generation
+	ecs::Entity released = e[63];
+	ecs::pool_release(&world.pool, released);
+	ecs::Entity reused = ecs::pool_create(&world.pool);
+	check(ecs::entity_index(reused) == ecs::entity_index(released), "the released slot is reused");
+	ecs::pool_release(&world.pool, e[14]);
+
+	u32 visited = 0;
+	bool all_tagged = true;
+	bool stale = false;
+	ecs::tag_each(hidden, &world.pool, [&](ecs::Entity t) {
+		visited++;
+		all_tagged = all_tagged && ecs::tag_has(hidden, t) && ecs::pool_alive(&world.pool, t);
+		stale = stale || t == released || ecs::entity_index(t) == ecs::entity_index(e[14]);
+	});
+	check(visited == hidden_count - 1, "tag_each visits every live tagged slot once");
+	check(all_tagged, "tag_each hands out live, tagged handles");
+	check(!stale, "tag_each skips released slots");
+	ecs::tag_remove(hidden, reused);
+	e[63] = reused;
+	hidden_count--;
+
+	// Capture: every entity has a transform and a mesh; hidden ones must not be drawn
+	AABB unit = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	ecs::RenderSnapshots snapshots = {};
+	ecs::render_snapshots_set_asset_bounds(&snapshots, &unit, 1);
+	for (u32 i = 0; i < ENTITY_COUNT; i++) {
+		if (!ecs::pool_alive(&world.pool, e[i])) continue;
+		ecs::Transform t = {};
+		t.rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+		t.scale = { 1.0f, 1.0f, 1.0f };
+		t.local_to_world = mat3x4_from_trs({ (f32)i, 0.0f, 0.0f }, t.rotation, t.scale);
+		ecs::store_add(&world.transforms, e[i], t);
+		ecs::store_add(&world.mesh_instances, e[i], ecs::MeshInstance{ 0 });
+	}
+
+	for (u32 pass = 0; pass < 2; pass++) {
+		ecs::render_snapshots_capture(&snapshots, &world);
+		ecs::store_clear_changed(&world.transforms);
+		ecs::render_snapshots_swap(&snapshots);
+		const ecs::RenderSnapshot* front = ecs::render_snapshot_front(&snapshots);
+
+		u32 drawn = 0;
+		u32 hidden_live = 0;
+		bool right = true;
+		for (u32 k = 0; k < (u32)front->entities.count; k++) {
+			bool shown = front->asset_ids.data[k] != ecs::INVALID_INDEX;
+			bool tagged = ecs::tag_has(hidden, front->entities.data[k]);
+			right = right && shown != tagged;
+			if (tagged) hidden_live++;
+			if (!shown) continue;
+			drawn++;
+			const ecs::Transform* t = ecs::store_get(&world.transforms, front->entities.data[k]);
+			right = right && front->models.data[k].row[0][3] == t->local_to_world.row[0][3];
+		}
+		check(right, pass == 0 ? "hidden entries are left out, the rest carry their model" : "shown entries come back with their model");
+		check(drawn + hidden_live == (u32)world.mesh_instances.data.count, "every shown entry is drawn");
+		check(hidden_live == (pass == 0 ? hidden_count - 1 : 0), "the hidden count matches"); // e14 was released
+
+		ecs::tag_clear(hidden);
+		check(hidden->count == 0 && !ecs::tag_has(hidden, e[0]), "tag_clear empties the set");
+	}
+
+	printf("%u failures\n", failures);
+	ecs::render_snapshots_destroy(&snapshots);
+	ecs::world_destroy(&world);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+#include "gl_harness.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glcorearb.h>
+
+#define HARNESS_GL_PROCS(X) \
+	X(PFNGLGETSTRINGPROC, glGetString) \
+	X(PFNGLGETERRORPROC, glGetError) \
+	X(PFNGLCREATESHADERPROC, glCreateShader) \
+	X(PFNGLSHADERSOURCEPROC, glShaderSource) \
+	X(PFNGLCOMPILESHADERPROC, glCompileShader) \
+	X(PFNGLGETSHADERIVPROC, glGetShaderiv) \
+	X(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog) \
+	X(PFNGLCREATEPROGRAMPROC, glCreateProgram) \
+	X(PFNGLATTACHSHADERPROC, glAttachShader) \
+	X(PFNGLLINKPROGRAMPROC, glLinkProgram) \
+	X(PFNGLGETPROGRAMIVPROC, glGetProgramiv) \
+	X(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog) \
+	X(PFNGLUSEPROGRAMPROC, glUseProgram) \
+	X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation) \
+	X(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv) \
+	X(PFNGLUNIFORM1IPROC, glUniform1i) \
+	X(PFNGLCREATEBUFFERSPROC, glCreateBuffers) \
+	X(PFNGLNAMEDBUFFERSTORAGEPROC, glNamedBufferStorage) \
+	X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers) \
+	X(PFNGLNAMEDBUFFERSUBDATAPROC, glNamedBufferSubData) \
+	X(PFNGLGETNAMEDBUFFERSUBDATAPROC, glGetNamedBufferSubData) \
+	X(PFNGLBINDBUFFERPROC, glBindBuffer) \
+	X(PFNGLBINDBUFFERRANGEPROC, glBindBufferRange) \
+	X(PFNGLCREATEFRAMEBUFFERSPROC, glCreateFramebuffers) \
+	X(PFNGLCREATERENDERBUFFERSPROC, glCreateRenderbuffers) \
+	X(PFNGLNAMEDRENDERBUFFERSTORAGEPROC, glNamedRenderbufferStorage) \
+	X(PFNGLNAMEDFRAMEBUFFERRENDERBUFFERPROC, glNamedFramebufferRenderbuffer) \
+	X(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer) \
+	X(PFNGLCREATETEXTURESPROC, glCreateTextures) \
+	X(PFNGLTEXTURESTORAGE2DPROC, glTextureStorage2D) \
+	X(PFNGLTEXTURESUBIMAGE2DPROC, glTextureSubImage2D) \
+	X(PFNGLBINDTEXTUREUNITPROC, glBindTextureUnit) \
+	X(PFNGLVIEWPORTPROC, glViewport) \
+	X(PFNGLCLEARCOLORPROC, glClearColor) \
+	X(PFNGLCLEARPROC, glClear) \
+	X(PFNGLENABLEPROC, glEnable) \
+	X(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray) \
+	X(PFNGLVERTEXARRAYVERTEXBUFFERPROC, glVertexArrayVertexBuffer) \
+	X(PFNGLMULTIDRAWELEMENTSINDIRECTPROC, glMultiDrawElementsIndirect) \
+	X(PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC, glDrawElementsInstancedBaseVertex) \
+	X(PFNGLGENQUERIESPROC, glGenQueries) \
+	X(PFNGLBEGINQUERYPROC, glBeginQuery) \
+	X(PFNGLENDQUERYPROC, glEndQuery) \
+	X(PFNGLGETQUERYOBJECTUIVPROC, glGetQueryObjectuiv) \
+	X(PFNGLREADPIXELSPROC, glReadPixels)
+
+// Prefixed so they can't clash with the repo's loader in the other translation unit
+#define HARNESS_DECLARE(type, name) static type gl_##name;
+HARNESS_GL_PROCS(HARNESS_DECLARE)
+
+static GLuint framebuffer;
+static GLuint white_texture;
+static GLuint primitives_query;
+static GLuint draw_program;
+static GLuint template_buffer;
+static GLuint reference_list;
+static u32    reference_capacity;
+static u32    indirect_pixels[HARNESS_SIZE * HARNESS_SIZE];
+static u32    reference_pixels[HARNESS_SIZE * HARNESS_SIZE];
+
+static char* read_file(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return nullptr;
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* text = (char*)malloc((size_t)size + 1);
+	size_t read = fread(text, 1, (size_t)size, file);
+	text[read] = 0;
+	fclose(file);
+	return text;
+}
+
+static GLuint compile(GLenum type, const char* path) {
+	char* source = read_file(path);
+	if (!source) { printf("can't read %s\n", path); exit(1); }
+	GLuint shader = gl_glCreateShader(type);
+	gl_glShaderSource(shader, 1, &source, nullptr);
+	gl_glCompileShader(shader);
+	free(source);
+	GLint ok;
+	gl_glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		char log[4096];
+		gl_glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		printf("%s:\n%s\n", path, log);
+		exit(1);
+	}
+	return shader;
+}
+
+static GLuint link(GLuint first, GLuint second) {
+	GLuint program = gl_glCreateProgram();
+	gl_glAttachShader(program, first);
+	if (second) gl_glAttachShader(program, second);
+	gl_glLinkProgram(program);
+	GLint ok;
+	gl_glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		char log[4096];
+		gl_glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+		printf("link:\n%s\n", log);
+		exit(1);
+	}
+	return program;
+}
+
+bool harness_gl_init(const char* shader_dir, GlGetProc* get_proc) {
+	auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (!get_platform_display) { printf("EGL_EXT_platform_base missing\n"); return false; }
+	EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	EGLint major, minor;
+	if (!eglInitialize(display, &major, &minor)) { printf("eglInitialize failed\n"); return false; }
+	eglBindAPI(EGL_OPENGL_API);
+	EGLint attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+	if (!context || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		printf("no GL 4.5 core context (EGL error %x)\n", eglGetError());
+		return false;
+	}
+#define HARNESS_LOAD(type, name) gl_##name = (type)eglGetProcAddress(#name);
+	HARNESS_GL_PROCS(HARNESS_LOAD)
+	*get_proc = (GlGetProc)eglGetProcAddress;
+	printf("%s | %s\n", gl_glGetString(GL_RENDERER), gl_glGetString(GL_VERSION));
+
+	char vert[512], frag[512];
+	snprintf(vert, sizeof(vert), "%s/shader.vert", shader_dir);
+	snprintf(frag, sizeof(frag), "%s/shader.frag", shader_dir);
+	draw_program = link(compile(GL_VERTEX_SHADER, vert), compile(GL_FRAGMENT_SHADER, frag));
+
+	GLuint renderbuffers[2];
+	gl_glCreateFramebuffers(1, &framebuffer);
+	gl_glCreateRenderbuffers(2, renderbuffers);
+	gl_glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, HARNESS_SIZE, HARNESS_SIZE);
+	gl_glNamedRenderbufferStorage(renderbuffers[1], GL_DEPTH_COMPONENT24, HARNESS_SIZE, HARNESS_SIZE);
+	gl_glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+	gl_glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+	u32 white = 0xFFFFFFFFu;
+	gl_glCreateTextures(GL_TEXTURE_2D, 1, &white_texture);
+	gl_glTextureStorage2D(white_texture, 1, GL_RGBA8, 1, 1);
+	gl_glTextureSubImage2D(white_texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	gl_glGenQueries(1, &primitives_query);
+	return true;
+}
+
+u32 harness_compile_compute(const char* path) {
+	return link(compile(GL_COMPUTE_SHADER, path), 0);
+}
+
+u32 harness_upload_templates(const void* data, u32 size) {
+	static u32 capacity = 0;
+	if (size > capacity) {
+		if (template_buffer) gl_glDeleteBuffers(1, &template_buffer);
+		capacity = size * 2;
+		gl_glCreateBuffers(1, &template_buffer);
+		gl_glNamedBufferStorage(template_buffer, HARNESS_TEMPLATE_OFFSET + capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+	if (size) gl_glNamedBufferSubData(template_buffer, HARNESS_TEMPLATE_OFFSET, size, data);
+	return template_buffer;
+}
+
+void harness_read(u32 buffer, u32 size, void* dst) {
+	if (size) gl_glGetNamedBufferSubData(buffer, 0, size, dst);
+}
+
+static void bind_target(const f32* vp) {
+	gl_glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	gl_glViewport(0, 0, HARNESS_SIZE, HARNESS_SIZE);
+	gl_glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	gl_glEnable(GL_DEPTH_TEST);
+	gl_glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	gl_glUseProgram(draw_program);
+	gl_glUniformMatrix4fv(gl_glGetUniformLocation(draw_program, "u_vp"), 1, GL_FALSE, vp);
+	gl_glUniform1i(gl_glGetUniformLocation(draw_program, "u_albedo"), 0);
+	gl_glBindTextureUnit(0, white_texture);
+}
+
+void harness_draw_indirect(u32 vao, u32 commands, u32 models, u32 models_size, const f32* vp, u32 draw_count, u32* primitives, u32* lit) {
+	bind_target(vp);
+	gl_glBindVertexArray(vao);
+	gl_glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands);
+	gl_glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, models, 0, models_size);
+	gl_glBeginQuery(GL_PRIMITIVES_GENERATED, primitives_query);
+	gl_glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)draw_count, 0);
+	gl_glEndQuery(GL_PRIMITIVES_GENERATED);
+	gl_glGetQueryObjectuiv(primitives_query, GL_QUERY_RESULT, primitives);
+	gl_glReadPixels(0, 0, HARNESS_SIZE, HARNESS_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, indirect_pixels);
+	*lit = 0;
+	for (u32 pixel : indirect_pixels) *lit += pixel != 0;
+}
+
+u32 harness_draw_reference(u32 vao, const u32* entries, u32 count, u32 index_count, u32 first_index, i32 base_vertex) {
+	if (count > reference_capacity) {
+		if (reference_list) gl_glDeleteBuffers(1, &reference_list);
+		reference_capacity = count * 2;
+		gl_glCreateBuffers(1, &reference_list);
+		gl_glNamedBufferStorage(reference_list, reference_capacity * sizeof(u32), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+	if (count) gl_glNamedBufferSubData(reference_list, 0, count * sizeof(u32), entries);
+	// Binding 1 is the per-instance id stream geometry_bind_instance_ids points at the visible list
+	gl_glVertexArrayVertexBuffer(vao, 1, reference_list, 0, sizeof(u32));
+	gl_glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	gl_glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)index_count, GL_UNSIGNED_INT,
+		(const void*)(usize)(first_index * sizeof(u32)), (GLsizei)count, base_vertex);
+	gl_glReadPixels(0, 0, HARNESS_SIZE, HARNESS_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, reference_pixels);
+	u32 diff = 0;
+	for (u32 i = 0; i < HARNESS_SIZE * HARNESS_SIZE; i++) diff += reference_pixels[i] != indirect_pixels[i];
+	return diff;
+}
+
+u32 harness_gl_error() {
+	return gl_glGetError();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../../src/core/types.hpp"
+
+// The raw GL half of the harness: an EGL surfaceless context, the draw shaders, and the offscreen
+// target both draws render into. It lives in its own translation unit because the system GL
+// headers and renderer/opengl/opengl.hpp declare the same names.
+
+using GlGetProc = void* (*)(const char* name);
+
+constexpr u32 HARNESS_SIZE = 128;            // offscreen target, square
+constexpr u32 HARNESS_TEMPLATE_OFFSET = 256; // where command templates sit in the source buffer
+
+// Creates a GL 4.5 core context and links shaders/shader.vert + shader.frag from shader_dir.
+// Returns false when EGL or the context is unavailable.
+bool harness_gl_init(const char* shader_dir, GlGetProc* get_proc);
+u32  harness_compile_compute(const char* path);
+// Writes size bytes at HARNESS_TEMPLATE_OFFSET of a buffer standing in for the frame ring.
+u32  harness_upload_templates(const void* data, u32 size);
+void harness_read(u32 buffer, u32 size, void* dst);
+// Draws draw_count indirect commands the way render() does, with vao's instance ids already bound.
+// Reports the primitives generated and the pixels covered, and keeps the image for the reference.
+void harness_draw_indirect(u32 vao, u32 commands, u32 models, u32 models_size, const f32* vp, u32 draw_count, u32* primitives, u32* lit);
+// One instanced draw over a CPU-built entry list; returns the pixels that differ from the last
+// harness_draw_indirect image.
+u32  harness_draw_reference(u32 vao, const u32* entries, u32 count, u32 index_count, u32 first_index, i32 base_vertex);
+u32  harness_gl_error();
@@ -0,0 +1,232 @@
+// Runs the GPU culling path (app/gpu_cull.cpp, shaders/cull.comp, the geometry buffer and the draw
+// shaders) against real snapshot captures and checks it against the CPU. Over 40 frames of an
+// orbiting camera with moving transforms, a structural change and skipped captures:
+//   - the resident models match the snapshot after full and page-wise uploads,
+//   - every group's visible list holds exactly the entries the CPU frustum test keeps,
+//   - the indirect commands keep their templates and count only those instances,
+//   - the primitives drawn match, and the multi-draw image is pixel-identical to one instanced
+//     draw over the CPU's entry list.
+//
+// The app is Win32-only; this runs on Linux through an EGL surfaceless context, so any Mesa driver
+// works, including llvmpipe with no GPU. See run.sh. Exits with 1 on any failure.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gl_harness.hpp"
+#include "../../src/app/gpu_cull.hpp"
+#include "../../src/renderer/opengl/geometry.hpp"
+
+void stub_gl_init(GlGetProc get_proc, u32 cull_program);
+
+constexpr u32 ENTITY_COUNT = 20000;
+constexpr u32 ASSET_COUNT = 6; // the last asset has no bounds, so its instances are never drawn
+constexpr u32 MAX_COMMANDS = 16384;
+constexpr u32 FRAMES = 40;
+
+static u32 rng_state = 0x1234567u;
+
+static u32 rng_next() {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static f32 random_f32() {
+	return (f32)(rng_next() >> 8) / (f32)(1u << 24) * 2.0f - 1.0f;
+}
+
+// Smallest signed plane distance of box, the quantity cull.comp and frustum_test_aabb compare to 0
+static f32 frustum_distance(const Frustum& frustum, const AABB& box) {
+	vec3 c = (box.min + box.max) * 0.5f;
+	vec3 e = (box.max - box.min) * 0.5f;
+	f32 nearest = 1e30f;
+	for (int p = 0; p < 6; p++) {
+		const vec4& plane = frustum.planes[p];
+		f32 d = plane.x * c.x + plane.y * c.y + plane.z * c.z + fabsf(plane.x) * e.x + fabsf(plane.y) * e.y + fabsf(plane.z) * e.z + plane.w;
+		if (d < nearest) nearest = d;
+	}
+	return nearest;
+}
+
+int main(int argc, char** argv) {
+	const char* shader_dir = argc > 1 ? argv[1] : "shaders";
+	GlGetProc get_proc;
+	if (!harness_gl_init(shader_dir, &get_proc)) return 1;
+	char cull_path[512];
+	snprintf(cull_path, sizeof(cull_path), "%s/cull.comp", shader_dir);
+	stub_gl_init(get_proc, harness_compile_compute(cull_path));
+
+	GpuCull cull;
+	if (!gpu_cull_init(&cull, MAX_COMMANDS)) { printf("gpu_cull_init failed\n"); return 1; }
+
+	// A cube, added twice so the drawn range has a non-zero first_index and base_vertex
+	opengl::Vertex vertices[8] = {};
+	for (int i = 0; i < 8; i++) {
+		vertices[i].position = { (i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f };
+	}
+	u32 indices[36] = { 0,1,3, 0,3,2, 4,6,7, 4,7,5, 0,4,5, 0,5,1, 2,3,7, 2,7,6, 0,2,6, 0,6,4, 1,5,7, 1,7,3 };
+	opengl::GeometryBuffer geometry;
+	opengl::geometry_init(&geometry, 4, 4);
+	opengl::geometry_add(&geometry, vertices, 8, indices, 36);
+	opengl::GeometryRange cube = opengl::geometry_add(&geometry, vertices, 8, indices, 36);
+
+	ecs::World world;
+	ecs::world_init(&world, 1 << 16);
+	ecs::RenderSnapshots snapshots = {};
+	AABB asset_bounds[ASSET_COUNT - 1];
+	for (u32 a = 0; a < ASSET_COUNT - 1; a++) asset_bounds[a] = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	ecs::render_snapshots_set_asset_bounds(&snapshots, asset_bounds, ASSET_COUNT - 1);
+
+	// Every 97th instance has no transform either
+	ecs::Entity* entities = (ecs::Entity*)memory::malloc(ENTITY_COUNT * sizeof(ecs::Entity));
+	for (u32 i = 0; i < ENTITY_COUNT; i++) {
+		entities[i] = ecs::pool_create(&world.pool);
+		ecs::Transform t = {};
+		t.position = { random_f32() * 100.0f, random_f32() * 100.0f, random_f32() * 100.0f };
+		t.rotation = { 0.0f, 0.0f, 0.0f, 1.0f };
+		t.scale = { 1.0f, 1.0f, 1.0f };
+		t.local_to_world = mat3x4_from_trs(t.position, t.rotation, t.scale);
+		if (i % 97) ecs::store_add(&world.transforms, entities[i], t);
+		ecs::store_add(&world.mesh_instances, entities[i], ecs::MeshInstance{ rng_next() % ASSET_COUNT });
+	}
+
+	memory::FrameArena arena;
+	memory::frame_arena_init(&arena, 1 << 20);
+	u32 failures = 0, ambiguous = 0;
+	u64 pages_sent = 0, pages_total = 0;
+	for (u32 frame = 0; frame < FRAMES; frame++) {
+		// Simulation: some transforms move, frame 15 removes an instance, and every ninth frame
+		// captures twice so the renderer skips one
+		u32 captures = frame % 9 == 4 ? 2 : 1;
+		for (u32 pass = 0; pass < captures; pass++) {
+			u32 changes = frame % 7 == 0 ? 0 : rng_next() % 200;
+			for (u32 k = 0; k < changes; k++) {
+				ecs::Entity e = entities[rng_next() % ENTITY_COUNT];
+				ecs::Transform* t = ecs::store_get(&world.transforms, e);
+				if (!t) continue;
+				t->position.y += random_f32() * 30.0f;
+				t->local_to_world = mat3x4_from_trs(t->position, t->rotation, t->scale);
+				ecs::store_mark_changed(&world.transforms, e);
+			}
+			if (frame == 15 && pass == 0) ecs::store_remove(&world.mesh_instances, entities[10]);
+			ecs::render_snapshots_capture(&snapshots, &world);
+			ecs::store_clear_changed(&world.transforms);
+			ecs::render_snapshots_swap(&snapshots);
+		}
+		const ecs::RenderSnapshot* snapshot = ecs::render_snapshot_front(&snapshots);
+		u32 count = (u32)snapshot->asset_ids.count;
+		u32 group_count = (u32)snapshot->groups.count;
+
+		f32 angle = (f32)frame * 0.4f;
+		vec3 eye = { cosf(angle) * 60.0f, 10.0f, sinf(angle) * 60.0f };
+		mat4 vp = mat4_perspective(1.0f, 1.0f, 0.1f, 120.0f) * mat4_look_at(eye, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+		Frustum frustum = frustum_from_vp(vp);
+
+		// Render, as render() does on the GPU path
+		memory::frame_begin(&arena);
+		gpu_cull_sync(&cull, snapshot, &arena);
+		pages_sent += cull.uploaded_pages;
+		pages_total += (count + ecs::SNAPSHOT_PAGE_SIZE - 1) >> ecs::SNAPSHOT_PAGE_BITS;
+		opengl::DrawElementsIndirectCommand* templates = memory::frame_push<opengl::DrawElementsIndirectCommand>(&arena, group_count);
+		for (u32 g = 0; g < group_count; g++) {
+			templates[g] = { cube.index_count, 0, cube.first_index, cube.base_vertex, snapshot->groups.data[g].begin };
+		}
+		u32 source = harness_upload_templates(templates, group_count * (u32)sizeof(opengl::DrawElementsIndirectCommand));
+		gpu_cull_dispatch(&cull, frustum, source, HARNESS_TEMPLATE_OFFSET, group_count);
+		opengl::geometry_bind_instance_ids(&geometry, cull.visible);
+		u32 primitives, lit;
+		harness_draw_indirect(geometry.vao, cull.commands, cull.models, count * (u32)sizeof(mat3x4), &vp.col[0][0], group_count, &primitives, &lit);
+
+		// Read back what the GPU built
+		opengl::DrawElementsIndirectCommand* commands = memory::frame_push<opengl::DrawElementsIndirectCommand>(&arena, group_count);
+		u32* visible = memory::frame_push<u32>(&arena, count);
+		mat3x4* models = memory::frame_push<mat3x4>(&arena, count);
+		harness_read(cull.commands, group_count * (u32)sizeof(opengl::DrawElementsIndirectCommand), commands);
+		harness_read(cull.visible, count * (u32)sizeof(u32), visible);
+		harness_read(cull.models, count * (u32)sizeof(mat3x4), models);
+
+		for (u32 i = 0; i < count; i++) {
+			if (snapshot->asset_ids.data[i] != ecs::INVALID_INDEX && memcmp(&models[i], &snapshot->models.data[i], sizeof(mat3x4)) != 0) {
+				printf("frame %u: resident model %u differs from the snapshot\n", frame, i);
+				failures++;
+				break;
+			}
+		}
+
+		u8* in_visible = memory::frame_push<u8>(&arena, count);
+		memory::set(in_visible, 0, count);
+		u32* expected = memory::frame_push<u32>(&arena, count);
+		u32 expected_count = 0, instances = 0;
+		for (u32 g = 0; g < group_count; g++) {
+			const ecs::KeyRange& range = snapshot->groups.data[g];
+			const opengl::DrawElementsIndirectCommand& command = commands[g];
+			if (command.count != cube.index_count || command.first_index != cube.first_index
+				|| command.base_vertex != cube.base_vertex || command.base_instance != range.begin || command.instance_count > range.count) {
+				printf("frame %u: command %u lost its template\n", frame, g);
+				failures++;
+				continue;
+			}
+			for (u32 slot = 0; slot < command.instance_count; slot++) {
+				u32 entry = visible[range.begin + slot];
+				if (entry < range.begin || entry >= range.begin + range.count || in_visible[entry]) {
+					printf("frame %u: group %u slot %u holds entry %u\n", frame, g, slot, entry);
+					failures++;
+					continue;
+				}
+				in_visible[entry] = 1;
+			}
+			for (u32 i = range.begin; i < range.begin + range.count; i++) {
+				bool drawn = snapshot->proxies.data[i] != bvh::NULL_NODE;
+				f32 distance = drawn ? frustum_distance(frustum, snapshot->bounds.data[i]) : -1.0f;
+				bool keep = drawn && distance >= 0.0f;
+				if (keep) expected[expected_count++] = i;
+				// Boxes touching a plane may go either way between the GPU and CPU
+				if ((in_visible[i] != 0) != keep) {
+					if (drawn && fabsf(distance) < 1e-3f) {
+						ambiguous++;
+					} else {
+						printf("frame %u: entry %u %s\n", frame, i, keep ? "culled on the GPU" : "kept on the GPU");
+						failures++;
+					}
+				}
+				if (drawn && fabsf(distance) > 1e-3f && frustum_test_aabb(frustum, snapshot->bounds.data[i]) != keep) failures++;
+			}
+			instances += command.instance_count;
+		}
+
+		if (primitives != instances * 12) {
+			printf("frame %u: %u primitives, expected %u\n", frame, primitives, instances * 12);
+			failures++;
+		}
+		if (instances > 0 && lit == 0) {
+			printf("frame %u: %u instances drawn, no pixels covered\n", frame, instances);
+			failures++;
+		}
+		u32 diff = harness_draw_reference(geometry.vao, expected, expected_count, cube.index_count, cube.first_index, cube.base_vertex);
+		if (diff) {
+			printf("frame %u: %u pixels differ from the reference draw\n", frame, diff);
+			failures++;
+		}
+		if (frame % 8 == 0) {
+			printf("frame %2u: capture %u%s, %u of %u entries in %u draws, %u px covered, %u pages sent\n",
+				frame, snapshot->capture, snapshot->full_copy ? " (full)" : "", instances, count, group_count, lit, cull.uploaded_pages);
+		}
+	}
+
+	u32 error = harness_gl_error();
+	if (error) {
+		printf("GL error %x\n", error);
+		failures++;
+	}
+	printf("%u failures, %u boxes on a plane, %llu of %llu pages sent\n", failures, ambiguous, pages_sent, pages_total);
+
+	gpu_cull_destroy(&cull);
+	opengl::geometry_destroy(&geometry);
+	memory::frame_arena_destroy(&arena);
+	memory::free(entities);
+	ecs::render_snapshots_destroy(&snapshots);
+	ecs::world_destroy(&world);
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+// Stand-ins for the Win32 pieces the code under test links against: the GL loader in
+// renderer/opengl/opengl.cpp, the shader registry, the CRT aligned heap and the job system. Jobs run
+// inline on the calling thread.
+
+#include <stdlib.h>
+
+#include "gl_harness.hpp"
+#include "../../src/core/jobs.hpp"
+#include "../../src/renderer/opengl/opengl.hpp"
+#include "../../src/renderer/opengl/shader.hpp"
+
+#define STUB_GL_PROCS(X) \
+	X(PFNGLCREATEBUFFERSPROC, glCreateBuffers) \
+	X(PFNGLNAMEDBUFFERSTORAGEPROC, glNamedBufferStorage) \
+	X(PFNGLDELETEBUFFERSPROC, glDeleteBuffers) \
+	X(PFNGLNAMEDBUFFERSUBDATAPROC, glNamedBufferSubData) \
+	X(PFNGLCOPYNAMEDBUFFERSUBDATAPROC, glCopyNamedBufferSubData) \
+	X(PFNGLBINDBUFFERRANGEPROC, glBindBufferRange) \
+	X(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation) \
+	X(PFNGLUSEPROGRAMPROC, glUseProgram) \
+	X(PFNGLUNIFORM1UIPROC, glUniform1ui) \
+	X(PFNGLUNIFORM4FVPROC, glUniform4fv) \
+	X(PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute) \
+	X(PFNGLMEMORYBARRIERPROC, glMemoryBarrier) \
+	X(PFNGLCREATEVERTEXARRAYSPROC, glCreateVertexArrays) \
+	X(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays) \
+	X(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray) \
+	X(PFNGLVERTEXARRAYVERTEXBUFFERPROC, glVertexArrayVertexBuffer) \
+	X(PFNGLVERTEXARRAYELEMENTBUFFERPROC, glVertexArrayElementBuffer) \
+	X(PFNGLVERTEXARRAYATTRIBFORMATPROC, glVertexArrayAttribFormat) \
+	X(PFNGLVERTEXARRAYATTRIBIFORMATPROC, glVertexArrayAttribIFormat) \
+	X(PFNGLVERTEXARRAYATTRIBBINDINGPROC, glVertexArrayAttribBinding) \
+	X(PFNGLENABLEVERTEXARRAYATTRIBPROC, glEnableVertexArrayAttrib) \
+	X(PFNGLVERTEXARRAYBINDINGDIVISORPROC, glVertexArrayBindingDivisor) \
+	X(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced)
+
+namespace opengl {
+
+#define STUB_DEFINE(type, name) type name = nullptr;
+	STUB_GL_PROCS(STUB_DEFINE)
+
+	static GLuint cull_program;
+
+	GLuint shader_get(const char*) {
+		return cull_program;
+	}
+
+}
+
+// Loads the repo-side procs through the harness context and registers shaders/cull.comp as "cull".
+void stub_gl_init(GlGetProc get_proc, u32 cull_program) {
+#define STUB_LOAD(type, name) opengl::name = (opengl::type)get_proc(#name);
+	STUB_GL_PROCS(STUB_LOAD)
+	opengl::cull_program = cull_program;
+}
+
+extern "C" void* _aligned_malloc(size_t size, size_t alignment) {
+	return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+extern "C" void _aligned_free(void* ptr) {
+	free(ptr);
+}
+
+extern "C" long long _InterlockedIncrement64(long long volatile* addend) {
+	return __atomic_add_fetch(addend, 1, __ATOMIC_RELAXED);
+}
+
+namespace jobs {
+
+	void init(u32) {}
+	void shutdown() {}
+	u32 worker_count() { return 0; }
+	u32 thread_index() { return 0; }
+	void submit(Group*, JobFn fn, void* user, u32 begin, u32 end) { fn(user, begin, end); }
+	void submit_background(Group*, JobFn fn, void* user) { fn(user, 0, 1); }
+	void wait(Group*) {}
+	bool done(const Group*) { return true; }
+
+	void parallel_for(u32 count, u32 min_batch, JobFn fn, void* user) {
+		u32 step = min_batch ? min_batch : 1;
+		for (u32 begin = 0; begin < count; begin += step) fn(user, begin, begin + step < count ? begin + step : count);
+	}
+
+}
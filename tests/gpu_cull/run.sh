@@ -0,0 +1,18 @@
+#!/bin/sh
+# Builds and runs gpu_cull_test on Linux against any Mesa GL 4.5 driver. For the software
+# rasterizer with no GPU:
+#   LIBGL_ALWAYS_SOFTWARE=1 tests/gpu_cull/run.sh
+# Needs g++ and the EGL/GL development headers (libegl-dev, mesa-common-dev, libgl-dev).
+set -e
+root="$(cd "$(dirname "$0")/../.." && pwd)"
+out="${TMPDIR:-/tmp}/gpu_cull_test"
+g++ -std=c++14 -O1 -include stddef.h \
+	"$root/tests/gpu_cull/gpu_cull_test.cpp" \
+	"$root/tests/gpu_cull/gl_harness.cpp" \
+	"$root/tests/gpu_cull/platform_stubs.cpp" \
+	"$root/src/app/gpu_cull.cpp" \
+	"$root/src/renderer/opengl/geometry.cpp" \
+	"$root/src/renderer/opengl/mesh.cpp" \
+	"$root/src/core/memory.cpp" \
+	-lEGL -o "$out"
+"$out" "$root/shaders"